@@ -0,0 +1,543 @@
+/* threefry_benchmark.cpp
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+/*
+Throughput of the threefry4x64 engines, for tracking performance regressions.
+
+Every combination of rounds (13, 20, 72) and return width (8, 16, 32, 64 bits)
+is measured with operator() per value, with the block-wise fill() and with
+generate_blocks(), and 64 bit engines also with next_block(), plus encrypt_blocks() with every block kernel the CPU
+supports. Each benchmark is run in 1 or more threads, every thread with its
+own engine. many_engines draws from 65536 engines in turn, where the size of
+the engine state matters; the sizeof column is that size. The 64 bit engine
+with 20 rounds is also measured with the 64 byte aligned layout (_align64) and
+without the output block (_nocache).
+
+A benchmark is first run at least --warmup times, doubling the amount of work
+until one run takes --min-time seconds, and is then timed --reps times. The
+summary reports the median, mean, standard deviation, minimum and maximum of
+the nanoseconds per value, and the median cycles per byte. Cycles are time
+stamp counter ticks (rdtsc on x86), which tick at a constant rate that may
+differ from the actual core clock. With several threads the nanoseconds per
+value are those of all threads together, the cycles per byte are per thread.
+
+usage: threefry_benchmark [--format=text|csv|json] [--reps=N] [--warmup=N]
+                          [--min-time=seconds] [--threads=1,2,4] [--filter=text]
+*/
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <memory>
+
+#include <boost/cstdint.hpp>
+#include <boost/random/threefry4x64.hpp>
+#include <boost/random/threefry.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define THREEFRY_BENCHMARK_HAS_TSC
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define THREEFRY_BENCHMARK_HAS_TSC
+#endif
+
+namespace {
+
+boost::uint64_t ticks()
+{
+#ifdef THREEFRY_BENCHMARK_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// the work of a benchmark: run(seed, batches) does batches * values_per_batch
+// values with an engine seeded with seed and returns something that depends
+// on all of them. If set, prepare(threads) sets up the state of the runs of
+// that many threads before the clock starts, prepare(0) frees it.
+struct benchmark
+{
+    std::string engine;
+    std::string method;
+    std::string isa;
+    std::size_t rounds;
+    std::size_t bits;
+    std::size_t state_bytes;
+    std::size_t values_per_batch;
+    std::function<boost::uint64_t(unsigned int, std::size_t)> run;
+    std::function<void(unsigned int)> prepare;
+};
+
+struct measurement
+{
+    double seconds;
+    double ticks;
+};
+
+struct summary
+{
+    const benchmark* bench;
+    unsigned int threads;
+    std::size_t reps;
+    double values;      // per rep, all threads together
+    double ns_median;
+    double ns_mean;
+    double ns_stddev;
+    double ns_min;
+    double ns_max;
+    double cycles_per_byte;
+    double gb_per_s;
+};
+
+struct options
+{
+    std::string format;
+    std::size_t reps;
+    std::size_t warmup;
+    double min_time;
+    std::vector<unsigned int> threads;
+    std::string filter;
+};
+
+volatile boost::uint64_t sink;
+
+const std::size_t batch = 4096;
+
+template<class Engine>
+boost::uint64_t run_operator(unsigned int seed, std::size_t batches)
+{
+    Engine eng(seed);
+    boost::uint64_t x = 0;
+    for (std::size_t b=0; b<batches; ++b)
+        for (std::size_t i=0; i<batch; ++i)
+            x ^= eng();
+    return x;
+}
+
+// batch / 4 blocks of 4 values each
+template<class Engine>
+boost::uint64_t run_next_block(unsigned int seed, std::size_t batches)
+{
+    Engine eng(seed);
+    boost::uint64_t x = 0;
+    for (std::size_t b=0; b<batches; ++b) {
+        for (std::size_t i=0; i<batch/4; ++i) {
+            const typename Engine::block_type block = eng.next_block();
+            x ^= block[0] ^ block[1] ^ block[2] ^ block[3];
+        }
+    }
+    return x;
+}
+
+// one value of each engine in turn, the engine states don't fit in the L2 cache.
+// The engines of the thread with seed s are engines[s-1], built by prepare()
+// so that the timed runs only draw.
+template<class Engine>
+struct many_engines
+{
+    many_engines()
+    : engines(new std::vector<std::vector<Engine> >())
+    {}
+
+    void prepare(unsigned int threads) const
+    {
+        const std::size_t n = 65536;
+        engines->assign(threads, std::vector<Engine>());
+        for (unsigned int t=0; t<threads; ++t) {
+            (*engines)[t].reserve(n);
+            for (std::size_t i=0; i<n; ++i)
+                (*engines)[t].push_back(Engine(t + 1).substream(i));
+        }
+    }
+
+    boost::uint64_t run(unsigned int seed, std::size_t batches) const
+    {
+        std::vector<Engine>& eng = (*engines)[seed - 1];
+        boost::uint64_t x = 0;
+        std::size_t k = 0;
+        for (std::size_t b=0; b<batches; ++b) {
+            for (std::size_t i=0; i<batch; ++i) {
+                x ^= eng[k]();
+                if (++k == eng.size()) k = 0;
+            }
+        }
+        return x;
+    }
+
+    std::shared_ptr<std::vector<std::vector<Engine> > > engines;
+};
+
+template<class Engine>
+boost::uint64_t run_fill(unsigned int seed, std::size_t batches)
+{
+    Engine eng(seed);
+    std::vector<typename Engine::result_type> buffer(batch);
+    boost::uint64_t x = 0;
+    for (std::size_t b=0; b<batches; ++b) {
+        eng.fill(&buffer[0], &buffer[0] + batch);
+        x ^= buffer[b % batch];
+    }
+    return x;
+}
+
+template<class Engine>
+boost::uint64_t run_generate_blocks(unsigned int seed, std::size_t batches)
+{
+    const std::size_t nblocks = batch / Engine::samples_per_block;
+    Engine eng(seed);
+    std::vector<boost::uint64_t> buffer(4*nblocks);
+    boost::uint64_t x = 0;
+    for (std::size_t b=0; b<batches; ++b) {
+        eng.generate_blocks(&buffer[0], nblocks);
+        x ^= buffer[b % buffer.size()];
+    }
+    return x;
+}
+
+// generate_blocks() of a counter_based_engine, blocks of ctr_words words
+template<class Engine>
+boost::uint64_t run_counter_blocks(unsigned int seed, std::size_t batches)
+{
+    const std::size_t nblocks = batch / Engine::samples_per_block;
+    Engine eng(seed);
+    std::vector<typename Engine::word_type> buffer(Engine::ctr_words*nblocks);
+    boost::uint64_t x = 0;
+    for (std::size_t b=0; b<batches; ++b) {
+        eng.generate_blocks(&buffer[0], nblocks);
+        x ^= buffer[b % buffer.size()];
+    }
+    return x;
+}
+
+// batch / 4 blocks of 4 values each
+template<std::size_t Rounds>
+boost::uint64_t run_encrypt_blocks(unsigned int seed, std::size_t batches)
+{
+    typedef boost::random::threefry4x64<Rounds> threefry;
+    const typename threefry::key_type key = {{ seed, 0, 0, 0 }};
+    typename threefry::ctr_type ctr = {{ 0, 0, 0, 0 }};
+    const boost::random::threefry4x64_key_schedule<Rounds> schedule(key);
+    std::vector<boost::uint64_t> buffer(batch);
+    boost::uint64_t x = 0;
+    for (std::size_t b=0; b<batches; ++b) {
+        schedule.encrypt_blocks(ctr, &buffer[0], batch/4);
+        ctr[0] += batch/4;
+        x ^= buffer[b % batch];
+    }
+    return x;
+}
+
+template<class UIntType, std::size_t Bits, std::size_t Rounds, class Layout>
+void add_engine(std::vector<benchmark>& benchmarks, const char* layout = "")
+{
+    typedef boost::random::threefry4x64_engine<UIntType, Bits, Rounds, 4, 4, Layout> engine;
+    std::ostringstream name;
+    name << "threefry4x64_" << Rounds << "_" << Bits << layout;
+
+    const benchmark op = { name.str(), "operator()", "", Rounds, Bits, sizeof(engine), batch, &run_operator<engine>, nullptr };
+    const many_engines<engine> engines;
+    const benchmark many = { name.str(), "many_engines", "", Rounds, Bits, sizeof(engine), batch,
+        [engines](unsigned int seed, std::size_t batches) { return engines.run(seed, batches); },
+        [engines](unsigned int threads) { engines.prepare(threads); } };
+    const benchmark fill = { name.str(), "fill", "", Rounds, Bits, sizeof(engine), batch, &run_fill<engine>, nullptr };
+    const benchmark blocks = { name.str(), "generate_blocks", "", Rounds, Bits, sizeof(engine), batch, &run_generate_blocks<engine>, nullptr };
+    benchmarks.push_back(op);
+    benchmarks.push_back(many);
+    benchmarks.push_back(fill);
+    benchmarks.push_back(blocks);
+    if (Bits == 64) {
+        const benchmark next = { name.str(), "next_block", "", Rounds, Bits, sizeof(engine), batch, &run_next_block<engine>, nullptr };
+        benchmarks.push_back(next);
+    }
+}
+
+template<std::size_t Rounds>
+void add_rounds(std::vector<benchmark>& benchmarks)
+{
+    typedef boost::random::threefry4x64_layout<> layout;
+    add_engine<boost::uint8_t, 8, Rounds, layout>(benchmarks);
+    add_engine<boost::uint16_t, 16, Rounds, layout>(benchmarks);
+    add_engine<boost::uint32_t, 32, Rounds, layout>(benchmarks);
+    add_engine<boost::uint64_t, 64, Rounds, layout>(benchmarks);
+    if (Rounds == 20) {
+        add_engine<boost::uint64_t, 64, Rounds, boost::random::threefry4x64_layout<64> >(benchmarks, "_align64");
+        add_engine<boost::uint64_t, 64, Rounds, boost::random::threefry4x64_layout<0, false> >(benchmarks, "_nocache");
+    }
+
+    const boost::random::threefry4x64_isa isas[] = { boost::random::threefry4x64_isa_scalar,
+        boost::random::threefry4x64_isa_sse2, boost::random::threefry4x64_isa_avx2, boost::random::threefry4x64_isa_avx512 };
+    const char* isa_names[] = { "scalar", "sse2", "avx2", "avx512" };
+    std::ostringstream name;
+    name << "threefry4x64<" << Rounds << ">";
+    for (std::size_t k=0; k<4; ++k) {
+        if (!boost::random::threefry4x64_isa_supported(isas[k])) continue;
+        const benchmark b = { name.str(), "encrypt_blocks", isa_names[k], Rounds, 64,
+            sizeof(boost::random::threefry4x64_key_schedule<Rounds>), batch, &run_encrypt_blocks<Rounds>, nullptr };
+        benchmarks.push_back(b);
+    }
+}
+
+// the 4x32 engine, its generate_blocks() with every kernel
+void add_threefry4x32(std::vector<benchmark>& benchmarks)
+{
+    typedef boost::random::threefry4x32_20 engine;
+    const char* name = "threefry4x32_20";
+    const benchmark op = { name, "operator()", "", 20, 32, sizeof(engine), batch, &run_operator<engine>, nullptr };
+    const benchmark fill = { name, "fill", "", 20, 32, sizeof(engine), batch, &run_fill<engine>, nullptr };
+    benchmarks.push_back(op);
+    benchmarks.push_back(fill);
+
+    const boost::random::threefry4x64_isa isas[] = { boost::random::threefry4x64_isa_scalar,
+        boost::random::threefry4x64_isa_sse2, boost::random::threefry4x64_isa_avx2, boost::random::threefry4x64_isa_avx512 };
+    const char* isa_names[] = { "scalar", "sse2", "avx2", "avx512" };
+    for (std::size_t k=0; k<4; ++k) {
+        if (!boost::random::threefry4x64_isa_supported(isas[k])) continue;
+        const benchmark b = { name, "generate_blocks", isa_names[k], 20, 32, sizeof(engine), batch, &run_counter_blocks<engine>, nullptr };
+        benchmarks.push_back(b);
+    }
+}
+
+boost::random::threefry4x64_isa isa_of(const benchmark& b)
+{
+    if (b.isa == "scalar") return boost::random::threefry4x64_isa_scalar;
+    if (b.isa == "sse2") return boost::random::threefry4x64_isa_sse2;
+    if (b.isa == "avx2") return boost::random::threefry4x64_isa_avx2;
+    if (b.isa == "avx512") return boost::random::threefry4x64_isa_avx512;
+    return boost::random::threefry4x64_isa_auto;
+}
+
+// one run of batches per thread, all threads start together
+measurement measure(const benchmark& b, unsigned int threads, std::size_t batches)
+{
+    if (b.prepare)
+        b.prepare(threads);
+
+    std::atomic<bool> go(false);
+    std::atomic<unsigned int> ready(0);
+    std::vector<boost::uint64_t> results(threads);
+    std::vector<std::thread> workers;
+    for (unsigned int t=1; t<threads; ++t) {
+        workers.push_back(std::thread([&, t]() {
+            ++ready;
+            while (!go.load()) {}
+            results[t] = b.run(t + 1, batches);
+        }));
+    }
+    while (ready.load() + 1 < threads) {}
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const boost::uint64_t start_ticks = ticks();
+    go = true;
+    results[0] = b.run(1, batches);
+    for (std::size_t i=0; i<workers.size(); ++i)
+        workers[i].join();
+    const boost::uint64_t end_ticks = ticks();
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    for (unsigned int t=0; t<threads; ++t)
+        sink = sink ^ results[t];
+    const measurement m = { std::chrono::duration<double>(end - start).count(), static_cast<double>(end_ticks - start_ticks) };
+    return m;
+}
+
+double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    const std::size_t n = v.size();
+    return n % 2 ? v[n/2] : (v[n/2 - 1] + v[n/2]) / 2;
+}
+
+summary run_benchmark(const benchmark& b, unsigned int threads, const options& opt)
+{
+    boost::random::threefry4x64_force_isa(isa_of(b));
+
+    // warm up, and find the number of batches that takes at least min_time
+    std::size_t batches = 1;
+    for (std::size_t i=0; ; ++i) {
+        const measurement m = measure(b, threads, batches);
+        if (m.seconds >= opt.min_time && i + 1 >= opt.warmup) break;
+        if (m.seconds < opt.min_time) batches *= 2;
+    }
+
+    const double values = static_cast<double>(batches) * b.values_per_batch * threads;
+    const double bytes_per_thread = static_cast<double>(batches) * b.values_per_batch * b.bits / 8;
+    std::vector<double> ns(opt.reps);
+    std::vector<double> cycles(opt.reps);
+    for (std::size_t r=0; r<opt.reps; ++r) {
+        const measurement m = measure(b, threads, batches);
+        ns[r] = m.seconds * 1e9 / values;
+        cycles[r] = m.ticks / bytes_per_thread;
+    }
+    boost::random::threefry4x64_force_isa(boost::random::threefry4x64_isa_auto);
+    if (b.prepare)
+        b.prepare(0);
+
+    summary s;
+    s.bench = &b;
+    s.threads = threads;
+    s.reps = opt.reps;
+    s.values = values;
+    s.ns_median = median(ns);
+    s.ns_min = *std::min_element(ns.begin(), ns.end());
+    s.ns_max = *std::max_element(ns.begin(), ns.end());
+    double sum = 0;
+    for (std::size_t r=0; r<ns.size(); ++r) sum += ns[r];
+    s.ns_mean = sum / ns.size();
+    double sum2 = 0;
+    for (std::size_t r=0; r<ns.size(); ++r) sum2 += (ns[r] - s.ns_mean) * (ns[r] - s.ns_mean);
+    s.ns_stddev = ns.size() > 1 ? std::sqrt(sum2 / (ns.size() - 1)) : 0.0;
+    s.cycles_per_byte = median(cycles);
+    s.gb_per_s = b.bits / 8.0 / s.ns_median;
+    return s;
+}
+
+void print_text_header()
+{
+    std::cout << std::left << std::setw(28) << "engine" << std::setw(16) << "method" << std::setw(8) << "isa"
+              << std::right << std::setw(8) << "sizeof" << std::setw(8) << "threads" << std::setw(12) << "ns/value" << std::setw(10) << "+-"
+              << std::setw(10) << "min" << std::setw(10) << "max" << std::setw(12) << "cycles/B" << std::setw(10) << "GB/s"
+              << std::endl;
+}
+
+void print_text(const summary& s)
+{
+    const benchmark& b = *s.bench;
+    std::cout << std::left << std::setw(28) << b.engine << std::setw(16) << b.method << std::setw(8) << (b.isa.empty() ? "auto" : b.isa)
+              << std::right << std::setw(8) << b.state_bytes << std::setw(8) << s.threads << std::fixed << std::setprecision(3)
+              << std::setw(12) << s.ns_median << std::setw(10) << s.ns_stddev << std::setw(10) << s.ns_min << std::setw(10) << s.ns_max
+              << std::setw(12) << s.cycles_per_byte << std::setw(10) << s.gb_per_s << std::endl;
+}
+
+const char* csv_header =
+    "engine,method,isa,rounds,bits,sizeof,threads,reps,values,ns_per_value_median,ns_per_value_mean,"
+    "ns_per_value_stddev,ns_per_value_min,ns_per_value_max,cycles_per_byte,gb_per_s";
+
+void print_csv(const summary& s)
+{
+    const benchmark& b = *s.bench;
+    std::cout << b.engine << ',' << b.method << ',' << (b.isa.empty() ? "auto" : b.isa) << ',' << b.rounds << ',' << b.bits << ',' << b.state_bytes << ','
+              << s.threads << ',' << s.reps << ',' << std::setprecision(12) << s.values << ',' << std::setprecision(6)
+              << s.ns_median << ',' << s.ns_mean << ',' << s.ns_stddev << ',' << s.ns_min << ',' << s.ns_max << ','
+              << s.cycles_per_byte << ',' << s.gb_per_s << std::endl;
+}
+
+void print_json(const summary& s, bool first)
+{
+    const benchmark& b = *s.bench;
+    std::cout << (first ? "  " : ",\n  ")
+              << "{\"engine\": \"" << b.engine << "\", \"method\": \"" << b.method << "\", \"isa\": \"" << (b.isa.empty() ? "auto" : b.isa)
+              << "\", \"rounds\": " << b.rounds << ", \"bits\": " << b.bits << ", \"sizeof\": " << b.state_bytes << ", \"threads\": " << s.threads
+              << ", \"reps\": " << s.reps << ", \"values\": " << std::setprecision(12) << s.values << std::setprecision(6)
+              << ", \"ns_per_value\": {\"median\": " << s.ns_median << ", \"mean\": " << s.ns_mean << ", \"stddev\": " << s.ns_stddev
+              << ", \"min\": " << s.ns_min << ", \"max\": " << s.ns_max << "}"
+              << ", \"cycles_per_byte\": " << s.cycles_per_byte << ", \"gb_per_s\": " << s.gb_per_s << "}";
+}
+
+bool parse(int argc, char* argv[], options& opt)
+{
+    opt.format = "text";
+    opt.reps = 9;
+    opt.warmup = 2;
+    opt.min_time = 0.02;
+    opt.threads.push_back(1);
+    const unsigned int cores = std::thread::hardware_concurrency();
+    if (cores > 1) opt.threads.push_back(cores);
+
+    for (int i=1; i<argc; ++i) {
+        const std::string arg = argv[i];
+        const std::size_t eq = arg.find('=');
+        const std::string key = arg.substr(0, eq);
+        const std::string value = eq == std::string::npos ? std::string() : arg.substr(eq + 1);
+        if (key == "--format" && (value == "text" || value == "csv" || value == "json"))
+            opt.format = value;
+        else if (key == "--reps" && std::atoi(value.c_str()) > 0)
+            opt.reps = std::atoi(value.c_str());
+        else if (key == "--warmup")
+            opt.warmup = std::atoi(value.c_str());
+        else if (key == "--min-time" && std::atof(value.c_str()) > 0)
+            opt.min_time = std::atof(value.c_str());
+        else if (key == "--filter")
+            opt.filter = value;
+        else if (key == "--threads") {
+            opt.threads.clear();
+            std::istringstream is(value);
+            std::string t;
+            while (std::getline(is, t, ','))
+                if (std::atoi(t.c_str()) > 0)
+                    opt.threads.push_back(std::atoi(t.c_str()));
+            if (opt.threads.empty()) return false;
+        }
+        else
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cerr << "usage: " << argv[0] << " [--format=text|csv|json] [--reps=N] [--warmup=N]\n"
+                  << "       [--min-time=seconds] [--threads=1,2,4] [--filter=text]" << std::endl;
+        return 1;
+    }
+
+    std::vector<benchmark> benchmarks;
+    add_rounds<13>(benchmarks);
+    add_rounds<20>(benchmarks);
+    add_rounds<72>(benchmarks);
+    add_threefry4x32(benchmarks);
+
+    if (opt.format == "text")
+        print_text_header();
+    else if (opt.format == "csv")
+        std::cout << csv_header << std::endl;
+    else
+        std::cout << "[\n";
+
+    bool first = true;
+    for (std::size_t t=0; t<opt.threads.size(); ++t) {
+        for (std::size_t i=0; i<benchmarks.size(); ++i) {
+            const benchmark& b = benchmarks[i];
+            const std::string name = b.engine + " " + b.method + " " + b.isa;
+            if (!opt.filter.empty() && name.find(opt.filter) == std::string::npos) continue;
+
+            const summary s = run_benchmark(b, opt.threads[t], opt);
+            if (opt.format == "text")
+                print_text(s);
+            else if (opt.format == "csv")
+                print_csv(s);
+            else
+                print_json(s, first);
+            first = false;
+        }
+    }
+
+    if (opt.format == "json")
+        std::cout << "\n]" << std::endl;
+    return 0;
+}
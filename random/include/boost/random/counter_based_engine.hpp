@@ -0,0 +1,469 @@
+/* boost random/counter_based_engine.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_COUNTER_BASED_ENGINE_HPP
+#define BOOST_RANDOM_COUNTER_BASED_ENGINE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <istream>
+
+#include <boost/array.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/config.hpp>
+#include <boost/limits.hpp>
+#include <boost/static_assert.hpp>
+
+#include <boost/random/detail/config.hpp>
+#include <boost/random/detail/counter_state.hpp>
+#include <boost/random/detail/seed.hpp>
+#include <boost/random/detail/seed_impl.hpp>
+
+namespace boost {
+namespace random {
+
+namespace detail {
+
+    // encrypts the counters ctr, ctr+1, .., ctr+n-1 and writes the n blocks
+    // to out as ctr_words consecutive words each. Ciphers with a many-blocks
+    // kernel specialize it, e.g. threefry4x32.
+    template<class Cipher>
+    struct cipher_blocks
+    {
+        static void encrypt(const typename Cipher::key_type& key, typename Cipher::ctr_type ctr,
+                            typename Cipher::word_type* out, std::size_t n)
+        {
+            for (; n > 0; --n) {
+                const typename Cipher::ctr_type block = Cipher::encrypt(key, ctr);
+                out = std::copy(block.begin(), block.end(), out);
+                for (std::size_t i=0; i<ctr.size(); ++i)
+                    if (++ctr[i] != 0) break;
+            }
+        }
+    };
+
+} // detail
+
+/**
+* @brief A random engine that encrypts a counter with a keyed block cipher.
+*
+* Every block of the cipher holds samples_per_block values of @p ReturnBits
+* bits, taken from the block in little endian order. The key is set by seeding
+* and the counter is incremented once per block, so discard() is O(1) and
+* engines with different keys produce independent sequences.
+*
+* parameter @p UIntType the return type of the random engine, must be an unsigned integral type.
+* parameter @p ReturnBits is the width of the return type, the number of bits. Valid values are 8,16,32,64.
+* parameter @p Cipher the block cipher. It has a @c word_type of @c word_bits bits, a
+* @c key_type and a @c ctr_type that are boost::array's of words, and a static function
+* <tt>ctr_type encrypt(const key_type&, const ctr_type&)</tt>, e.g. threefry2x64 or threefry4x64.
+*/
+template <  typename UIntType,
+            std::size_t ReturnBits,
+            class Cipher
+        >
+class counter_based_engine
+{
+public:
+    typedef UIntType result_type;
+    typedef Cipher cipher_type;
+    typedef typename Cipher::word_type word_type;
+    typedef typename Cipher::key_type key_type;
+    typedef typename Cipher::ctr_type ctr_type;
+
+    BOOST_STATIC_CONSTANT(std::size_t, word_size = ReturnBits);
+    BOOST_STATIC_CONSTANT(bool, has_fixed_range = false);
+    BOOST_STATIC_CONSTANT(std::size_t, key_words = key_type::static_size);
+    BOOST_STATIC_CONSTANT(std::size_t, ctr_words = ctr_type::static_size);
+    BOOST_STATIC_CONSTANT(std::size_t, samples_per_block = ctr_words * Cipher::word_bits / ReturnBits);
+
+    BOOST_STATIC_ASSERT( ReturnBits==8 || ReturnBits==16 || ReturnBits==32 || ReturnBits==64 );
+    BOOST_STATIC_ASSERT( (ctr_words * Cipher::word_bits) % ReturnBits == 0 );
+
+private:
+    /// \cond show_private
+    typedef detail::counter_state<word_type, Cipher::word_bits, ctr_words, samples_per_block> state;
+    /// \endcond
+
+public:
+    /**
+     * The number of most significant counter bits that select a stream, see
+     * seek_stream(): 64, or 32 for a 64 bit counter.
+     */
+    BOOST_STATIC_CONSTANT(std::size_t, stream_bits = state::stream_bits);
+
+    /**
+     * An absolute position in the sequence of values, blocks * samples_per_block + offset,
+     * as little endian 64 bit words, one more than the counter has. Positions are taken
+     * modulo the cycle length.
+     */
+    typedef typename state::position_type position_type;
+
+    /**
+     * @brief Constructs the default %counter_based_engine.
+     */
+    counter_based_engine()
+    { seed(0); }
+
+    /**
+     * @brief Constructs a %counter_based_engine with seed @p value.
+     */
+    BOOST_RANDOM_DETAIL_ARITHMETIC_CONSTRUCTOR(counter_based_engine, UIntType, value)
+    { seed(value); }
+
+    /**
+     * @brief Constructs a %counter_based_engine and seeds it with values
+     * taken from the iterator range [@p first, @p last) and adjusts first
+     * to point to the element after the last one used.  If there are not
+     * enough elements, throws @c std::invalid_argument.
+     */
+    template<class It> counter_based_engine(It& first, It last)
+    { seed(first, last); }
+
+    /**
+     * @brief Constructs a %counter_based_engine seeded from the seed sequence @p seq.
+     */
+    BOOST_RANDOM_DETAIL_SEED_SEQ_CONSTRUCTOR(counter_based_engine, SeedSeq, seq)
+    { seed(seq); }
+
+    /**
+     * @brief Re-seeds the %counter_based_engine to its default seed.
+     */
+    void seed()
+    { seed(0); }
+
+    /**
+     * @brief Re-seeds the %counter_based_engine with the seed @p value.
+     *
+     * The value fills the least significant key words, the others are 0.
+     */
+    BOOST_RANDOM_DETAIL_ARITHMETIC_SEED(counter_based_engine, UIntType, value)
+    {
+        boost::uintmax_t v = value;
+        for (std::size_t i=0; i<key_words; ++i) {
+            _key[i] = static_cast<word_type>(v);
+            v = (v >> (Cipher::word_bits/2)) >> (Cipher::word_bits/2);
+        }
+        reset_counter();
+    }
+
+    /**
+     * @brief Seeds the %counter_based_engine with the seed sequence @p seq.
+     */
+    BOOST_RANDOM_DETAIL_SEED_SEQ_SEED(counter_based_engine, SeeqSeq, seq)
+    {
+        word_type tmp[key_words];
+        detail::seed_array_int<Cipher::word_bits>(seq, tmp);
+        for (std::size_t i=0; i<key_words; ++i)
+            _key[i] = tmp[i];
+        reset_counter();
+    }
+
+    /**
+     * @brief Seeds the %counter_based_engine with values taken from the
+     * iterator range [@p first, @p last) and adjusts @p first to point to
+     * the element after the last one used.  If there are not enough
+     * elements, throws @c std::invalid_argument.
+     */
+    template<class It> void seed(It& first, It last)
+    {
+        word_type tmp[key_words];
+        detail::fill_array_int<Cipher::word_bits>(first, last, tmp);
+        for (std::size_t i=0; i<key_words; ++i)
+            _key[i] = tmp[i];
+        reset_counter();
+    }
+
+    /**
+     * @brief Gets the smallest possible value in the output range.
+     */
+    static result_type min BOOST_PREVENT_MACRO_SUBSTITUTION ()
+    { return 0; }
+
+    /**
+     * @brief Gets the largest possible value in the output range.
+     */
+    static result_type max BOOST_PREVENT_MACRO_SUBSTITUTION ()
+    { return (~static_cast<result_type>(0)) >> (std::numeric_limits<result_type>::digits - ReturnBits); }
+
+    /**
+     * @brief Generate a random sample.
+     */
+    result_type operator()()
+    {
+        if (_o_counter < samples_per_block)
+            return extract(_output.data(), _o_counter++);
+
+        if (_o_counter == samples_per_block) {
+            state::inc(_counter.elems);
+            _output = Cipher::encrypt(_key, _counter);
+            _o_counter = 1;
+            return extract(_output.data(), 0);
+        }
+
+        // the engine was positioned but the block is not encrypted yet
+        _o_counter &= ~lazy_flag;
+        _output = Cipher::encrypt(_key, _counter);
+        return extract(_output.data(), _o_counter++);
+    }
+
+    /**
+     * @brief Fills a range with random values.
+     */
+    template<class Iter>
+    void generate(Iter first, Iter last)
+    { detail::generate_from_int(*this, first, last); }
+
+    /**
+     * @brief Fills [@p first, @p last) with the values that successive calls
+     * of operator() would return, the full blocks in the middle with
+     * generate_blocks().
+     */
+    void fill(result_type* first, result_type* last)
+    {
+        std::size_t n = static_cast<std::size_t>(last - first);
+
+        // head: the rest of a partially consumed block
+        while (n > 0 && block_offset() % samples_per_block != 0) {
+            *first++ = (*this)();
+            --n;
+        }
+
+        // body: full blocks
+        word_type buffer[ctr_words*bulk_blocks];
+        while (n >= samples_per_block) {
+            const std::size_t nblocks = (std::min)(n/samples_per_block, static_cast<std::size_t>(bulk_blocks));
+            generate_blocks(buffer, nblocks);
+            for (std::size_t i=0; i<nblocks*samples_per_block; ++i)
+                *first++ = extract(buffer, i);
+            n -= nblocks*samples_per_block;
+        }
+
+        // tail: part of a new block
+        while (n > 0) {
+            *first++ = (*this)();
+            --n;
+        }
+    }
+
+    /**
+     * @brief Writes the next @p nblocks encrypted blocks to @p out.
+     *
+     * Each block is stored as ctr_words consecutive words. The blocks start
+     * at the first block boundary at or after the current position, and the
+     * engine is positioned at the end of the last block written, as with
+     * threefry4x64_engine::generate_blocks().
+     *
+     * @param out    destination of ctr_words * @p nblocks words.
+     * @param nblocks the number of blocks to generate.
+     */
+    void generate_blocks(word_type* out, std::size_t nblocks)
+    {
+        if (block_offset() != 0) {
+            state::inc(_counter.elems);
+            _o_counter = lazy_flag;
+        }
+        if (nblocks == 0) return;
+
+        detail::cipher_blocks<Cipher>::encrypt(_key, _counter, out, nblocks);
+        state::inc(_counter.elems, nblocks - 1);
+        _o_counter = samples_per_block;
+    }
+
+    /**
+     * @brief Returns the next encrypted block, same as generate_blocks()
+     * with a single block.
+     */
+    ctr_type next_block()
+    {
+        if (block_offset() != 0)
+            state::inc(_counter.elems);
+        const ctr_type block = Cipher::encrypt(_key, _counter);
+        _o_counter = samples_per_block;
+        return block;
+    }
+
+    /**
+     * @brief Discard a number of elements from the random numbers sequence.
+     *
+     * @param z the number of elements to discard.
+     */
+    void discard(boost::uintmax_t z)
+    { state::discard(_counter.elems, _o_counter, z); }
+
+    /**
+     * @brief Discard a multi-word number of elements from the random numbers
+     * sequence, the position wraps around at the end of the cycle.
+     *
+     * @param z the number of elements to discard.
+     */
+    void discard(const position_type& z)
+    { state::discard(_counter.elems, _o_counter, z); }
+
+    /**
+     * @brief Returns the absolute position of the next value in the sequence.
+     */
+    position_type tell() const
+    { return state::tell(_counter.elems, _o_counter); }
+
+    /**
+     * @brief Jumps to the absolute position @p p, keeping the key. The
+     * block is encrypted by the first draw.
+     */
+    void seek(const position_type& p)
+    { state::seek(_counter.elems, _o_counter, p); }
+
+    /**
+     * @brief Returns the index of the stream the engine is in.
+     */
+    boost::uint_least64_t stream() const
+    { return state::stream(_counter.elems, _o_counter); }
+
+    /**
+     * @brief Jumps to the start of stream @p s, keeping the key.
+     *
+     * The most significant stream_bits counter bits are the stream index,
+     * engines with the same key in different streams produce disjoint
+     * parts of the same sequence as long as neither draws beyond the end
+     * of its stream.
+     *
+     * @param s the stream index, must be smaller than 2^stream_bits.
+     */
+    void seek_stream(boost::uint_least64_t s)
+    { state::seek_stream(_counter.elems, _o_counter, s); }
+
+    /**
+     * @brief Returns a copy of the engine that starts at stream @p s.
+     */
+    counter_based_engine substream(boost::uint_least64_t s) const
+    {
+        counter_based_engine eng(*this);
+        eng.seek_stream(s);
+        return eng;
+    }
+
+#ifndef BOOST_RANDOM_NO_STREAM_OPERATORS
+    /**
+     * @brief Writes the key words, the counter words and the offset in the
+     * current block to @p os.
+     */
+    template<class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>&
+    operator << (std::basic_ostream<CharT, Traits>& os, const counter_based_engine& eng)
+    {
+        for (std::size_t i=0; i<key_words; ++i)
+            os << eng._key[i] << ' ';
+
+        for (std::size_t i=0; i<ctr_words; ++i)
+            os << eng._counter[i] << ' ';
+
+        os << eng.block_offset();
+        return os;
+    }
+
+    /**
+     * @brief Reads the key words, the counter words and the offset in the
+     * current block from @p is.
+     */
+    template<class CharT, class Traits>
+    friend std::basic_istream<CharT, Traits>&
+    operator >> (std::basic_istream<CharT, Traits>& is, counter_based_engine& eng)
+    {
+        for (std::size_t i=0; i<key_words; ++i)
+            is >> eng._key[i] >> std::ws;
+
+        for (std::size_t i=0; i<ctr_words; ++i)
+            is >> eng._counter[i] >> std::ws;
+
+        is >> eng._o_counter;
+
+        // the block gets encrypted by the first draw
+        if (eng._o_counter < samples_per_block)
+            eng._o_counter |= lazy_flag;
+        return is;
+    }
+#endif
+
+    /**
+     * @brief Compares two %counter_based_engine objects of the same type
+     * for equality.
+     *
+     * @returns true if the infinite sequences of generated values
+     *          would be equal, false otherwise.
+     */
+    friend bool
+    operator==(const counter_based_engine& _lhs, const counter_based_engine& _rhs)
+    {
+        if (_lhs._key != _rhs._key) return false;
+
+        // the end of a block is the same position as the start of the next block
+        ctr_type lhs_counter;
+        ctr_type rhs_counter;
+        std::size_t lhs_offset = state::normalize(_lhs._counter.elems, _lhs._o_counter, lhs_counter.elems);
+        std::size_t rhs_offset = state::normalize(_rhs._counter.elems, _rhs._o_counter, rhs_counter.elems);
+        return lhs_offset == rhs_offset && lhs_counter == rhs_counter;
+    }
+
+    /**
+     * @brief Compares two %counter_based_engine objects for inequality.
+     */
+    friend bool
+    operator!=(const counter_based_engine& _lhs, const counter_based_engine& _rhs)
+    { return !(_lhs == _rhs); }
+
+private:
+    // blocks per chunk of fill()
+    BOOST_STATIC_CONSTANT(std::size_t, bulk_blocks = 16);
+
+    // set in _o_counter when the engine has been positioned in a block that
+    // isn't encrypted yet, the remaining bits are the offset in the block
+    BOOST_STATIC_CONSTANT(boost::uint_least16_t, lazy_flag = state::lazy_flag);
+
+    // the offset in the current block
+    std::size_t block_offset() const
+    { return state::offset(_o_counter); }
+
+    // the n-th value of a sequence of blocks, little endian
+    static result_type extract(const word_type* blocks, std::size_t n)
+    {
+        if (ReturnBits <= Cipher::word_bits) {
+            const std::size_t per_word = (ReturnBits <= Cipher::word_bits) ? Cipher::word_bits / ReturnBits : 1;
+            return static_cast<result_type>((blocks[n / per_word] >> ((n % per_word) * ReturnBits)) & max BOOST_PREVENT_MACRO_SUBSTITUTION ());
+        }
+
+        // a value spans several words
+        const std::size_t words = ReturnBits / Cipher::word_bits;
+        result_type r = 0;
+        for (std::size_t i=0; i<words; ++i)
+            r |= static_cast<result_type>(blocks[n*words + i]) << (i * Cipher::word_bits);
+        return r;
+    }
+
+    void reset_counter()
+    { state::reset(_counter.elems, _o_counter); }
+
+    key_type _key;
+    ctr_type _counter;
+    ctr_type _output;
+    boost::uint_least16_t _o_counter;
+};
+
+#ifndef BOOST_NO_INCLASS_MEMBER_INITIALIZATION
+//  A definition is required even for integral static constants
+template<typename UIntType, std::size_t ReturnBits, class Cipher>
+const std::size_t counter_based_engine<UIntType, ReturnBits, Cipher>::stream_bits;
+#endif
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_COUNTER_BASED_ENGINE_HPP
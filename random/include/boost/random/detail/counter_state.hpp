@@ -0,0 +1,227 @@
+/* boost random/detail/counter_state.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_DETAIL_COUNTER_STATE_HPP
+#define BOOST_RANDOM_DETAIL_COUNTER_STATE_HPP
+
+#include <cstddef>
+
+#include <boost/array.hpp>
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+
+namespace boost {
+namespace random {
+namespace detail {
+
+// log2(N) of a power of two
+template<std::size_t N>
+struct counter_state_log2
+{ BOOST_STATIC_CONSTANT(std::size_t, value = 1 + counter_state_log2<N/2>::value); };
+
+template<>
+struct counter_state_log2<1>
+{ BOOST_STATIC_CONSTANT(std::size_t, value = 0); };
+
+/*
+ * The position of a counter based engine: a counter of Words little endian
+ * words of WordBits bits and the offset of the next value in the block of
+ * that counter, with SamplesPerBlock values per block. The functions work on
+ * the counter and offset members of the engine, so threefry4x64_engine and
+ * counter_based_engine share the state machine but keep their own layout.
+ *
+ * The offset is SamplesPerBlock after the last value of a block, and has
+ * lazy_flag set when the engine was positioned in a block that isn't
+ * encrypted yet.
+ */
+template<class Word, std::size_t WordBits, std::size_t Words, std::size_t SamplesPerBlock>
+struct counter_state
+{
+    BOOST_STATIC_ASSERT( (Words * WordBits) % 64 == 0 );
+    BOOST_STATIC_ASSERT( (SamplesPerBlock & (SamplesPerBlock - 1)) == 0 );
+
+    // the counter as 64 bit words
+    BOOST_STATIC_CONSTANT(std::size_t, words64 = Words * WordBits / 64);
+
+    // the most significant counter bits that select a stream
+    BOOST_STATIC_CONSTANT(std::size_t, stream_bits = (words64 > 1 ? 64 : 32));
+
+    BOOST_STATIC_CONSTANT(boost::uint_least16_t, lazy_flag = 0x8000);
+
+    // log2(SamplesPerBlock), the bits of a position that are the offset in a block
+    BOOST_STATIC_CONSTANT(std::size_t, block_shift = counter_state_log2<SamplesPerBlock>::value);
+
+    // blocks * SamplesPerBlock + offset as little endian 64 bit words
+    typedef boost::array<boost::uint_least64_t, words64 + 1> position_type;
+
+    // the offset in the current block
+    static std::size_t offset(boost::uint_least16_t o)
+    { return o & ~lazy_flag; }
+
+    // increment the counter with 1
+    static void inc(Word (&ctr)[Words])
+    {
+        for (std::size_t i=0; i<Words; ++i)
+            if (++ctr[i] != 0) break;
+    }
+
+    // increment the counter with z
+    static void inc(Word (&ctr)[Words], boost::uintmax_t z)
+    {
+        for (std::size_t i=0; i<Words && z != 0; ++i) {
+            const Word old = ctr[i];
+            ctr[i] = static_cast<Word>(old + static_cast<Word>(z));
+            z = ((z >> (WordBits/2)) >> (WordBits/2)) + (ctr[i] < old ? 1 : 0);
+        }
+    }
+
+    // counter zero, the block gets encrypted by the first draw
+    static void reset(Word (&ctr)[Words], boost::uint_least16_t& o)
+    {
+        for (std::size_t i=0; i<Words; ++i)
+            ctr[i] = 0;
+        o = lazy_flag;
+    }
+
+    // skip z values
+    static void discard(Word (&ctr)[Words], boost::uint_least16_t& o_counter, boost::uintmax_t z)
+    {
+        std::size_t o = offset(o_counter);
+
+        // check if we stay in the current block
+        if (z <= SamplesPerBlock - o) {
+            o_counter += static_cast<boost::uint_least16_t>(z);
+            if (o_counter == (lazy_flag | SamplesPerBlock))
+                o_counter = SamplesPerBlock;
+            return;
+        }
+
+        o += static_cast<std::size_t>(z % SamplesPerBlock);
+        z /= SamplesPerBlock;
+
+        if (o > SamplesPerBlock) {
+            o -= SamplesPerBlock;
+            ++z;
+        }
+
+        inc(ctr, z);
+
+        // the block gets encrypted by the first draw
+        if (o != SamplesPerBlock)
+            o |= lazy_flag;
+        o_counter = static_cast<boost::uint_least16_t>(o);
+    }
+
+    // the counter and offset of the next value, the end of a block is the
+    // start of the next one
+    static std::size_t normalize(const Word (&ctr)[Words], boost::uint_least16_t o, Word (&counter)[Words])
+    {
+        for (std::size_t i=0; i<Words; ++i)
+            counter[i] = ctr[i];
+        if (offset(o) != SamplesPerBlock)
+            return offset(o);
+
+        inc(counter);
+        return 0;
+    }
+
+    // the position of the next value
+    static position_type tell(const Word (&ctr)[Words], boost::uint_least16_t o)
+    {
+        Word counter[Words];
+        const std::size_t off = normalize(ctr, o, counter);
+        boost::uint_least64_t c[words64];
+        pack(counter, c);
+
+        position_type p;
+        p[0] = (c[0] << block_shift) | off;
+        for (std::size_t i=1; i<words64; ++i)
+            p[i] = (c[i] << block_shift) | high(c[i-1]);
+        p[words64] = high(c[words64-1]);
+        return p;
+    }
+
+    // jump to the position p, the block gets encrypted by the first draw
+    static void seek(Word (&ctr)[Words], boost::uint_least16_t& o, const position_type& p)
+    {
+        boost::uint_least64_t c[words64];
+        for (std::size_t i=0; i<words64; ++i)
+            c[i] = (p[i] >> block_shift) | ((p[i+1] << (63 - block_shift)) << 1);
+        unpack(c, ctr);
+        o = static_cast<boost::uint_least16_t>((p[0] & (SamplesPerBlock - 1)) | lazy_flag);
+    }
+
+    // skip the multi-word number of values z, modulo the cycle length
+    static void discard(Word (&ctr)[Words], boost::uint_least16_t& o, const position_type& z)
+    {
+        position_type p = tell(ctr, o);
+        boost::uint_least64_t carry = 0;
+        for (std::size_t i=0; i<words64+1; ++i) {
+            const boost::uint_least64_t sum = p[i] + carry;
+            carry = (sum < carry) ? 1 : 0;
+            p[i] = sum + z[i];
+            if (p[i] < sum) carry = 1;
+        }
+        seek(ctr, o, p);
+    }
+
+    // the stream of the next value: the top 64 counter bits, or the top
+    // half of a 64 bit counter
+    static boost::uint_least64_t stream(const Word (&ctr)[Words], boost::uint_least16_t o)
+    {
+        Word counter[Words];
+        normalize(ctr, o, counter);
+        boost::uint_least64_t c[words64];
+        pack(counter, c);
+        return (words64 > 1) ? c[words64-1] : (c[0] >> 32);
+    }
+
+    // jump to the start of stream s
+    static void seek_stream(Word (&ctr)[Words], boost::uint_least16_t& o, boost::uint_least64_t s)
+    {
+        BOOST_ASSERT( stream_bits == 64 || s <= 0xFFFFFFFF );
+
+        boost::uint_least64_t c[words64];
+        for (std::size_t i=0; i<words64; ++i)
+            c[i] = 0;
+        c[words64-1] = (words64 > 1) ? s : (s << 32);
+        unpack(c, ctr);
+        o = lazy_flag;
+    }
+
+private:
+    // the bits of a counter word that move to the next position word
+    static boost::uint_least64_t high(boost::uint_least64_t c)
+    { return (c >> (63 - block_shift)) >> 1; }
+
+    static void pack(const Word (&ctr)[Words], boost::uint_least64_t (&c)[words64])
+    {
+        for (std::size_t i=0; i<words64; ++i)
+            c[i] = 0;
+        for (std::size_t i=0; i<Words; ++i)
+            c[i*WordBits/64] |= static_cast<boost::uint_least64_t>(ctr[i]) << (i*WordBits % 64);
+    }
+
+    static void unpack(const boost::uint_least64_t (&c)[words64], Word (&ctr)[Words])
+    {
+        for (std::size_t i=0; i<Words; ++i)
+            ctr[i] = static_cast<Word>(c[i*WordBits/64] >> (i*WordBits % 64));
+    }
+};
+
+} // namespace detail
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_DETAIL_COUNTER_STATE_HPP
@@ -0,0 +1,765 @@
+/* boost random/detail/threefry4x64_kernel.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_DETAIL_THREEFRY4X64_KERNEL_HPP
+#define BOOST_RANDOM_DETAIL_THREEFRY4X64_KERNEL_HPP
+
+#include <cstddef>
+#include <cstring>
+
+#include <boost/cstdint.hpp>
+#include <boost/config.hpp>
+
+// Define BOOST_RANDOM_THREEFRY4X64_NO_SIMD to only use the scalar kernel.
+//
+// With GCC 4.9 or later and Clang on x86 the SSE2, AVX2 and AVX-512 kernels
+// are always compiled, each with its own target attribute, and the widest
+// kernel the CPU supports is selected at run time. Define
+// BOOST_RANDOM_THREEFRY4X64_NO_DISPATCH to only compile the kernels of the
+// instruction sets that are enabled at compile time, as other compilers do.
+#if !defined(BOOST_RANDOM_THREEFRY4X64_NO_SIMD)
+#  if !defined(BOOST_RANDOM_THREEFRY4X64_NO_DISPATCH) && (defined(__x86_64__) || defined(__i386__)) \
+      && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#    define BOOST_RANDOM_DETAIL_THREEFRY4X64_DISPATCH
+#    define BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX512
+#    define BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX2
+#    define BOOST_RANDOM_DETAIL_THREEFRY4X64_SSE2
+#  else
+#    if defined(__AVX512F__)
+#      define BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX512
+#    endif
+#    if defined(__AVX2__)
+#      define BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX2
+#    endif
+#    if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#      define BOOST_RANDOM_DETAIL_THREEFRY4X64_SSE2
+#    endif
+#  endif
+#endif
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_DISPATCH)
+#  define BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET(isa) __attribute__((target(isa)))
+#  define BOOST_RANDOM_DETAIL_THREEFRY4X64_ENTRY(isa) __attribute__((target(isa), flatten))
+#else
+#  define BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET(isa)
+#  define BOOST_RANDOM_DETAIL_THREEFRY4X64_ENTRY(isa) inline
+#endif
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX512) || defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX2) || defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_SSE2)
+#include <immintrin.h>
+#endif
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+#include <atomic>
+#endif
+
+// The generic round templates pass SIMD vectors to the target specific Ops.
+// They are always inlined into the entry points of their instruction set, so
+// the ABI of the out-of-line calls that GCC warns about never applies.
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_DISPATCH) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace boost {
+namespace random {
+
+/**
+ * @brief The implementations of the block kernel that encrypts many blocks
+ * per call, e.g. for generate_blocks(). All of them give the same blocks.
+ */
+enum threefry4x64_isa
+{
+    threefry4x64_isa_auto = 0,  ///< the widest kernel that the CPU supports, but scalar rather than SSE2
+    threefry4x64_isa_scalar,    ///< one block at a time in 64 bit registers
+    threefry4x64_isa_sse2,      ///< 2 blocks at a time
+    threefry4x64_isa_avx2,      ///< 4 blocks at a time
+    threefry4x64_isa_avx512     ///< 8 blocks at a time
+};
+
+namespace detail {
+
+/*
+ * The round schedule of the 4 word Threefry shapes, written once against an
+ * "Ops" policy that supplies the word type and the add, xor and rotate
+ * operations, so that Threefry4x64 and Threefry4x32 (threefry_kernel.hpp)
+ * share it. A scalar policy works on a single block, the SIMD policies work
+ * on several blocks at once in structure-of-arrays layout: x[j] holds word j
+ * of every block (lane).
+ *
+ * The subkeys are added by a "Key" policy, either computed on the fly from
+ * the key words and the parity word (threefry4_key) or taken from a
+ * precomputed key schedule (threefry4_expanded_key).
+ */
+
+// rotation constants of round R%8
+template<std::size_t R> struct threefry4x64_rotation;
+template<> struct threefry4x64_rotation<0> { BOOST_STATIC_CONSTANT(int, a = 14); BOOST_STATIC_CONSTANT(int, b = 16); };
+template<> struct threefry4x64_rotation<1> { BOOST_STATIC_CONSTANT(int, a = 52); BOOST_STATIC_CONSTANT(int, b = 57); };
+template<> struct threefry4x64_rotation<2> { BOOST_STATIC_CONSTANT(int, a = 23); BOOST_STATIC_CONSTANT(int, b = 40); };
+template<> struct threefry4x64_rotation<3> { BOOST_STATIC_CONSTANT(int, a =  5); BOOST_STATIC_CONSTANT(int, b = 37); };
+template<> struct threefry4x64_rotation<4> { BOOST_STATIC_CONSTANT(int, a = 25); BOOST_STATIC_CONSTANT(int, b = 33); };
+template<> struct threefry4x64_rotation<5> { BOOST_STATIC_CONSTANT(int, a = 46); BOOST_STATIC_CONSTANT(int, b = 12); };
+template<> struct threefry4x64_rotation<6> { BOOST_STATIC_CONSTANT(int, a = 58); BOOST_STATIC_CONSTANT(int, b = 22); };
+template<> struct threefry4x64_rotation<7> { BOOST_STATIC_CONSTANT(int, a = 32); BOOST_STATIC_CONSTANT(int, b = 32); };
+
+// rotation constants of round R%8 of the Words x WordBits shapes, the other
+// shapes are in threefry_kernel.hpp
+template<std::size_t Words, std::size_t WordBits, std::size_t R> struct threefry_rotation;
+template<std::size_t R> struct threefry_rotation<4, 64, R> : threefry4x64_rotation<R> {};
+
+// even rounds mix (x0,x1) and (x2,x3), odd rounds mix (x0,x3) and (x2,x1),
+// with the rotation constants of the word size of Ops
+template<class Ops, std::size_t R, bool Even = (R%2 == 0)>
+struct threefry4_mix
+{
+    typedef typename Ops::type type;
+    static BOOST_FORCEINLINE BOOST_CXX14_CONSTEXPR void apply(type (&x)[4])
+    {
+        x[0] = Ops::add(x[0], x[1]);
+        x[1] = Ops::xor_(Ops::template rotl<threefry_rotation<4, Ops::word_bits, R%8>::a>(x[1]), x[0]);
+        x[2] = Ops::add(x[2], x[3]);
+        x[3] = Ops::xor_(Ops::template rotl<threefry_rotation<4, Ops::word_bits, R%8>::b>(x[3]), x[2]);
+    }
+};
+
+template<class Ops, std::size_t R>
+struct threefry4_mix<Ops, R, false>
+{
+    typedef typename Ops::type type;
+    static BOOST_FORCEINLINE BOOST_CXX14_CONSTEXPR void apply(type (&x)[4])
+    {
+        x[0] = Ops::add(x[0], x[3]);
+        x[3] = Ops::xor_(Ops::template rotl<threefry_rotation<4, Ops::word_bits, R%8>::a>(x[3]), x[0]);
+        x[2] = Ops::add(x[2], x[1]);
+        x[1] = Ops::xor_(Ops::template rotl<threefry_rotation<4, Ops::word_bits, R%8>::b>(x[1]), x[2]);
+    }
+};
+
+// the key words ks[0..3] and the parity word ks[4], subkey s is ks[s..s+3] plus s
+template<class Ops>
+struct threefry4_key
+{
+    typedef typename Ops::type type;
+    
+    template<class Word>
+    explicit threefry4_key(const Word (&key)[5])
+    {
+        for (std::size_t i=0; i<5; ++i)
+            ks[i] = Ops::set1(key[i]);
+    }
+
+    // a different key in every lane: word j of lanes i, i+1, .. is key[j][i], key[j][i+1], ..
+    threefry4_key(const boost::uint_least64_t* const (&key)[5], std::size_t i)
+    {
+        for (std::size_t j=0; j<5; ++j)
+            ks[j] = Ops::loadu(key[j] + i);
+    }
+
+    template<std::size_t s>
+    BOOST_CXX14_CONSTEXPR void inject(type (&x)[4]) const
+    {
+        x[0] = Ops::add(x[0], ks[(s+0)%5]);
+        x[1] = Ops::add(x[1], ks[(s+1)%5]);
+        x[2] = Ops::add(x[2], ks[(s+2)%5]);
+        x[3] = Ops::add(x[3], ks[(s+3)%5]);
+        if (s != 0) x[3] = Ops::add(x[3], Ops::set1(s));
+    }
+
+    type ks[5];
+};
+
+// the key words ks[0..3] and the parity word ks[4] of a single block as an
+// aggregate, so that threefry4x64_encrypt_words() is usable in constant
+// expressions
+struct threefry4x64_word_key
+{
+    typedef boost::uint_least64_t type;
+
+    template<std::size_t s>
+    BOOST_CXX14_CONSTEXPR void inject(type (&x)[4]) const
+    {
+        x[0] += ks[(s+0)%5];
+        x[1] += ks[(s+1)%5];
+        x[2] += ks[(s+2)%5];
+        x[3] += ks[(s+3)%5];
+        if (s != 0) x[3] += s;
+    }
+
+    type ks[5];
+};
+
+// the key of the engine: the parity word followed by KeySize key words, the
+// other key words are zero and their additions are left out at compile time
+template<std::size_t KeySize>
+struct threefry4x64_short_key
+{
+    typedef boost::uint_least64_t type;
+
+    explicit threefry4x64_short_key(const boost::uint_least64_t* key) : k(key) {}
+
+    template<std::size_t s>
+    inline void inject(type (&x)[4]) const
+    {
+        add<(s+0)%5>(x[0]);
+        add<(s+1)%5>(x[1]);
+        add<(s+2)%5>(x[2]);
+        add<(s+3)%5>(x[3]);
+        if (s != 0) x[3] += s;
+    }
+
+    // x += ks[j]
+    template<std::size_t j>
+    inline void add(type& x) const
+    {
+        if (j == 4) x += k[0];
+        else if (j < KeySize) x += k[j+1];
+    }
+
+    const boost::uint_least64_t* k;
+};
+
+// a precomputed key schedule, subkey s is sk[s]
+template<class Ops, std::size_t Rounds>
+struct threefry4_expanded_key
+{
+    typedef typename Ops::type type;
+    BOOST_STATIC_CONSTANT(std::size_t, subkeys = Rounds/4 + 1);
+
+    template<class Word>
+    explicit threefry4_expanded_key(const Word (&schedule)[subkeys][4])
+    {
+        for (std::size_t s=0; s<subkeys; ++s)
+            for (std::size_t i=0; i<4; ++i)
+                sk[s][i] = Ops::set1(schedule[s][i]);
+    }
+
+    template<std::size_t s>
+    inline void inject(type (&x)[4]) const
+    {
+        x[0] = Ops::add(x[0], sk[s][0]);
+        x[1] = Ops::add(x[1], sk[s][1]);
+        x[2] = Ops::add(x[2], sk[s][2]);
+        x[3] = Ops::add(x[3], sk[s][3]);
+    }
+
+    type sk[subkeys][4];
+};
+
+// expand the key words and parity word to the Rounds/4+1 subkeys
+template<std::size_t Rounds, class Word>
+inline void threefry4_expand_key(const Word (&key)[5], Word (&schedule)[Rounds/4 + 1][4])
+{
+    for (std::size_t s=0; s<Rounds/4 + 1; ++s) {
+        for (std::size_t i=0; i<4; ++i)
+            schedule[s][i] = key[(s+i)%5];
+        schedule[s][3] += s;
+    }
+}
+
+// key injection after every 4th round
+template<class Ops, std::size_t R, bool Inject = ((R+1)%4 == 0)>
+struct threefry4_inject
+{
+    typedef typename Ops::type type;
+    template<class Key>
+    static BOOST_CXX14_CONSTEXPR void apply(type (&)[4], const Key&) {}
+};
+
+template<class Ops, std::size_t R>
+struct threefry4_inject<Ops, R, true>
+{
+    typedef typename Ops::type type;
+    template<class Key>
+    static BOOST_FORCEINLINE BOOST_CXX14_CONSTEXPR void apply(type (&x)[4], const Key& key)
+    { key.template inject<(R+1)/4>(x); }
+};
+
+// rounds R..Rounds-1
+template<class Ops, std::size_t Rounds, std::size_t R = 0, bool Done = (R >= Rounds)>
+struct threefry4_rounds
+{
+    typedef typename Ops::type type;
+    template<class Key>
+    static BOOST_FORCEINLINE BOOST_CXX14_CONSTEXPR void apply(type (&x)[4], const Key& key)
+    {
+        threefry4_mix<Ops, R>::apply(x);
+        threefry4_inject<Ops, R>::apply(x, key);
+        threefry4_rounds<Ops, Rounds, R+1>::apply(x, key);
+    }
+};
+
+template<class Ops, std::size_t Rounds, std::size_t R>
+struct threefry4_rounds<Ops, Rounds, R, true>
+{
+    typedef typename Ops::type type;
+    template<class Key>
+    static BOOST_CXX14_CONSTEXPR void apply(type (&)[4], const Key&) {}
+};
+
+
+// one block at a time. The stores go through std::memcpy, like the SIMD
+// intrinsics they may write to byte buffers, e.g. from fill_bytes(), without
+// breaking strict aliasing.
+struct threefry4x64_scalar_ops
+{
+    typedef boost::uint_least64_t type;
+    BOOST_STATIC_CONSTANT(std::size_t, lanes = 1);
+    BOOST_STATIC_CONSTANT(std::size_t, word_bits = 64);
+
+    static BOOST_CONSTEXPR type set1(boost::uint_least64_t v) { return v; }
+    static BOOST_CONSTEXPR type add(type a, type b) { return a + b; }
+    static BOOST_CONSTEXPR type xor_(type a, type b) { return a ^ b; }
+    template<int r>
+    static BOOST_CONSTEXPR type rotl(type a) { return (a << r) | (a >> (64 - r)); }
+
+    static inline type counter(boost::uint_least64_t c0) { return c0; }
+    static inline type loadu(const boost::uint_least64_t* p) { return *p; }
+    static inline void storeu(boost::uint_least64_t* p, type a) { std::memcpy(p, &a, sizeof(a)); }
+    static inline type gather4(const boost::uint_least64_t* p) { return *p; }
+    static inline void store(const type (&x)[4], boost::uint_least64_t* out)
+    { std::memcpy(out, x, sizeof(x)); }
+};
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_SSE2)
+// 2 blocks in the 2 lanes of a 128 bit register
+struct threefry4x64_sse2_ops
+{
+    typedef __m128i type;
+    BOOST_STATIC_CONSTANT(std::size_t, lanes = 2);
+    BOOST_STATIC_CONSTANT(std::size_t, word_bits = 64);
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type set1(boost::uint_least64_t v) { return _mm_set1_epi64x(static_cast<long long>(v)); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type add(type a, type b) { return _mm_add_epi64(a, b); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type xor_(type a, type b) { return _mm_xor_si128(a, b); }
+    template<int r>
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type rotl(type a) { return _mm_or_si128(_mm_slli_epi64(a, r), _mm_srli_epi64(a, 64 - r)); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type counter(boost::uint_least64_t c0)
+    { return _mm_add_epi64(set1(c0), _mm_set_epi64x(1, 0)); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type loadu(const boost::uint_least64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline void storeu(boost::uint_least64_t* p, type a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type gather4(const boost::uint_least64_t* p)
+    { return _mm_set_epi64x(static_cast<long long>(p[4]), static_cast<long long>(p[0])); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline void store(const type (&x)[4], boost::uint_least64_t* out)
+    {
+        storeu(out + 0, _mm_unpacklo_epi64(x[0], x[1]));
+        storeu(out + 2, _mm_unpacklo_epi64(x[2], x[3]));
+        storeu(out + 4, _mm_unpackhi_epi64(x[0], x[1]));
+        storeu(out + 6, _mm_unpackhi_epi64(x[2], x[3]));
+    }
+};
+#endif
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX2)
+// 4 blocks in the 4 lanes of a 256 bit register
+struct threefry4x64_avx2_ops
+{
+    typedef __m256i type;
+    BOOST_STATIC_CONSTANT(std::size_t, lanes = 4);
+    BOOST_STATIC_CONSTANT(std::size_t, word_bits = 64);
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type set1(boost::uint_least64_t v) { return _mm256_set1_epi64x(static_cast<long long>(v)); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type add(type a, type b) { return _mm256_add_epi64(a, b); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type xor_(type a, type b) { return _mm256_xor_si256(a, b); }
+    template<int r>
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type rotl(type a) { return _mm256_or_si256(_mm256_slli_epi64(a, r), _mm256_srli_epi64(a, 64 - r)); }
+
+    // lane i gets c0 + i
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type counter(boost::uint_least64_t c0)
+    { return _mm256_add_epi64(set1(c0), _mm256_set_epi64x(3, 2, 1, 0)); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type loadu(const boost::uint_least64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline void storeu(boost::uint_least64_t* p, type a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+
+    // lane i gets p[4*i], word j of 4 consecutive blocks when p points at word j of the first
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type gather4(const boost::uint_least64_t* p)
+    { return _mm256_set_epi64x(static_cast<long long>(p[12]), static_cast<long long>(p[8]), static_cast<long long>(p[4]), static_cast<long long>(p[0])); }
+
+    // transpose the 4x4 words back to consecutive blocks
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline void store(const type (&x)[4], boost::uint_least64_t* out)
+    {
+        __m256i t0 = _mm256_unpacklo_epi64(x[0], x[1]);
+        __m256i t1 = _mm256_unpackhi_epi64(x[0], x[1]);
+        __m256i t2 = _mm256_unpacklo_epi64(x[2], x[3]);
+        __m256i t3 = _mm256_unpackhi_epi64(x[2], x[3]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out +  0), _mm256_permute2x128_si256(t0, t2, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out +  4), _mm256_permute2x128_si256(t1, t3, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out +  8), _mm256_permute2x128_si256(t0, t2, 0x31));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 12), _mm256_permute2x128_si256(t1, t3, 0x31));
+    }
+};
+#endif
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX512)
+// 8 blocks in the 8 lanes of a 512 bit register, using the native 64 bit rotate.
+// The masked forms of the intrinsics with an all-ones mask compile to the same
+// instructions and avoid the uninitialized vectors of the unmasked ones that
+// GCC 12 warns about.
+struct threefry4x64_avx512_ops
+{
+    typedef __m512i type;
+    BOOST_STATIC_CONSTANT(std::size_t, lanes = 8);
+    BOOST_STATIC_CONSTANT(std::size_t, word_bits = 64);
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type set1(boost::uint_least64_t v) { return _mm512_set1_epi64(static_cast<long long>(v)); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type add(type a, type b) { return _mm512_add_epi64(a, b); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type xor_(type a, type b) { return _mm512_xor_si512(a, b); }
+    template<int r>
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type rotl(type a) { return _mm512_maskz_rol_epi64(0xFF, a, r); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type counter(boost::uint_least64_t c0)
+    { return _mm512_add_epi64(set1(c0), _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0)); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type loadu(const boost::uint_least64_t* p) { return _mm512_loadu_si512(p); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline void storeu(boost::uint_least64_t* p, type a) { _mm512_storeu_si512(p, a); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type gather4(const boost::uint_least64_t* p)
+    { return _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), 0xFF, _mm512_set_epi64(28, 24, 20, 16, 12, 8, 4, 0), p, 8); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline void store(const type (&x)[4], boost::uint_least64_t* out)
+    {
+        __m512i t0 = _mm512_maskz_unpacklo_epi64(0xFF, x[0], x[1]);     // lanes 0,2,4,6 of words 0,1
+        __m512i t1 = _mm512_maskz_unpackhi_epi64(0xFF, x[0], x[1]);     // lanes 1,3,5,7 of words 0,1
+        __m512i t2 = _mm512_maskz_unpacklo_epi64(0xFF, x[2], x[3]);
+        __m512i t3 = _mm512_maskz_unpackhi_epi64(0xFF, x[2], x[3]);
+        // interleave the 128 bit pairs so that each 256 bit half holds one block
+        const __m512i lo = _mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0);
+        const __m512i hi = _mm512_set_epi64(15, 14, 7, 6, 13, 12, 5, 4);
+        __m512i b02 = _mm512_permutex2var_epi64(t0, lo, t2);  // blocks 0 and 2
+        __m512i b46 = _mm512_permutex2var_epi64(t0, hi, t2);  // blocks 4 and 6
+        __m512i b13 = _mm512_permutex2var_epi64(t1, lo, t3);  // blocks 1 and 3
+        __m512i b57 = _mm512_permutex2var_epi64(t1, hi, t3);  // blocks 5 and 7
+        const __m512i first  = _mm512_set_epi64(11, 10, 9, 8, 3, 2, 1, 0);
+        const __m512i second = _mm512_set_epi64(15, 14, 13, 12, 7, 6, 5, 4);
+        _mm512_storeu_si512(out +  0, _mm512_permutex2var_epi64(b02, first,  b13));
+        _mm512_storeu_si512(out +  8, _mm512_permutex2var_epi64(b02, second, b13));
+        _mm512_storeu_si512(out + 16, _mm512_permutex2var_epi64(b46, first,  b57));
+        _mm512_storeu_si512(out + 24, _mm512_permutex2var_epi64(b46, second, b57));
+    }
+};
+#endif
+
+// encrypt Ops::lanes consecutive counters ctr, ctr+1, .. (the increment
+// only touches the first counter word) and store the blocks in order
+template<std::size_t Rounds, class Ops, class Key, class Word>
+inline void threefry4_encrypt_lanes(const Key& key, const Word (&ctr)[4], Word* out)
+{
+    typedef typename Ops::type type;
+    type x[4] = { Ops::counter(ctr[0]), Ops::set1(ctr[1]), Ops::set1(ctr[2]), Ops::set1(ctr[3]) };
+
+    key.template inject<0>(x);
+    threefry4_rounds<Ops, Rounds>::apply(x, key);
+    Ops::store(x, out);
+}
+
+// the Threefry4x64 names of the shared templates above
+template<class Ops, std::size_t Rounds, std::size_t R = 0>
+struct threefry4x64_rounds : threefry4_rounds<Ops, Rounds, R> {};
+
+template<class Ops>
+struct threefry4x64_key : threefry4_key<Ops>
+{
+    template<class Word>
+    explicit threefry4x64_key(const Word (&key)[5]) : threefry4_key<Ops>(key) {}
+    threefry4x64_key(const boost::uint_least64_t* const (&key)[5], std::size_t i) : threefry4_key<Ops>(key, i) {}
+};
+
+template<class Ops, std::size_t Rounds>
+struct threefry4x64_expanded_key : threefry4_expanded_key<Ops, Rounds>
+{
+    template<class Word>
+    explicit threefry4x64_expanded_key(const Word (&schedule)[Rounds/4 + 1][4])
+    : threefry4_expanded_key<Ops, Rounds>(schedule) {}
+};
+
+template<std::size_t Rounds, class Word>
+inline void threefry4x64_expand_key(const Word (&key)[5], Word (&schedule)[Rounds/4 + 1][4])
+{ threefry4_expand_key<Rounds>(key, schedule); }
+
+template<std::size_t Rounds, class Ops, class Key, class Word>
+inline void threefry4x64_encrypt_lanes(const Key& key, const Word (&ctr)[4], Word* out)
+{ threefry4_encrypt_lanes<Rounds, Ops>(key, ctr, out); }
+
+// encrypt the block x in place, a constant expression in C++14 and later
+template<std::size_t Rounds>
+BOOST_CXX14_CONSTEXPR void threefry4x64_encrypt_words(const threefry4x64_word_key& key, boost::uint_least64_t (&x)[4])
+{
+    key.template inject<0>(x);
+    threefry4_rounds<threefry4x64_scalar_ops, Rounds>::apply(x, key);
+}
+
+// encrypt a single block with a key schedule
+template<std::size_t Rounds>
+inline void threefry4x64_encrypt(const boost::uint_least64_t (&schedule)[Rounds/4 + 1][4], const boost::uint_least64_t (&ctr)[4], boost::uint_least64_t* out)
+{
+    const threefry4_expanded_key<threefry4x64_scalar_ops, Rounds> k(schedule);
+    threefry4_encrypt_lanes<Rounds, threefry4x64_scalar_ops>(k, ctr, out);
+}
+
+/*
+ * The many-blocks kernels. Each one keeps its position, and run<Ops>()
+ * encrypts as many multiples of Ops::lanes blocks as are left, so that
+ * threefry4x64_run() can hand the rest to the next narrower Ops.
+ */
+
+// the n counters ctr, ctr+1, .., the increment only touches the first counter word
+template<std::size_t Rounds>
+struct threefry4x64_blocks_kernel
+{
+    threefry4x64_blocks_kernel(const boost::uint_least64_t (&s)[Rounds/4 + 1][4], const boost::uint_least64_t (&c)[4], boost::uint_least64_t* o, std::size_t count)
+    : schedule(s), out(o), n(count)
+    {
+        for (std::size_t i=0; i<4; ++i)
+            ctr[i] = c[i];
+    }
+
+    template<class Ops>
+    inline void run()
+    {
+        if (n < Ops::lanes) return;
+        const threefry4_expanded_key<Ops, Rounds> key(schedule);
+        for (; n >= Ops::lanes; n -= Ops::lanes) {
+            threefry4_encrypt_lanes<Rounds, Ops>(key, ctr, out);
+            ctr[0] += Ops::lanes;
+            out += 4*Ops::lanes;
+        }
+    }
+
+    const boost::uint_least64_t (&schedule)[Rounds/4 + 1][4];
+    boost::uint_least64_t ctr[4];
+    boost::uint_least64_t* out;
+    std::size_t n;
+};
+
+// the n unrelated counters ctr[4*i .. 4*i+3]
+template<std::size_t Rounds>
+struct threefry4x64_counters_kernel
+{
+    threefry4x64_counters_kernel(const boost::uint_least64_t (&s)[Rounds/4 + 1][4], const boost::uint_least64_t* c, boost::uint_least64_t* o, std::size_t count)
+    : schedule(s), ctr(c), out(o), n(count)
+    {}
+
+    template<class Ops>
+    inline void run()
+    {
+        typedef typename Ops::type type;
+        if (n < Ops::lanes) return;
+        const threefry4_expanded_key<Ops, Rounds> key(schedule);
+        for (; n >= Ops::lanes; n -= Ops::lanes) {
+            type x[4] = { Ops::gather4(ctr), Ops::gather4(ctr + 1), Ops::gather4(ctr + 2), Ops::gather4(ctr + 3) };
+            key.template inject<0>(x);
+            threefry4_rounds<Ops, Rounds>::apply(x, key);
+            Ops::store(x, out);
+            ctr += 4*Ops::lanes;
+            out += 4*Ops::lanes;
+        }
+    }
+
+    const boost::uint_least64_t (&schedule)[Rounds/4 + 1][4];
+    const boost::uint_least64_t* ctr;
+    boost::uint_least64_t* out;
+    std::size_t n;
+};
+
+// the independent streams i .. i+n-1 in structure-of-arrays layout: stream i
+// encrypts the counter ctr[0..3][i] with the key words and parity word
+// key[0..4][i] and stores word j of its block in out[j][i]
+template<std::size_t Rounds>
+struct threefry4x64_streams_kernel
+{
+    threefry4x64_streams_kernel(const boost::uint_least64_t* const (&k)[5], const boost::uint_least64_t* const (&c)[4], boost::uint_least64_t* const (&o)[4], std::size_t first, std::size_t count)
+    : key(k), ctr(c), out(o), i(first), n(count)
+    {}
+
+    template<class Ops>
+    inline void run()
+    {
+        typedef typename Ops::type type;
+        for (; n >= Ops::lanes; n -= Ops::lanes, i += Ops::lanes) {
+            type x[4] = { Ops::loadu(ctr[0] + i), Ops::loadu(ctr[1] + i), Ops::loadu(ctr[2] + i), Ops::loadu(ctr[3] + i) };
+            const threefry4_key<Ops> k(key, i);
+            k.template inject<0>(x);
+            threefry4_rounds<Ops, Rounds>::apply(x, k);
+            for (std::size_t j=0; j<4; ++j)
+                Ops::storeu(out[j] + i, x[j]);
+        }
+    }
+
+    const boost::uint_least64_t* const (&key)[5];
+    const boost::uint_least64_t* const (&ctr)[4];
+    boost::uint_least64_t* const (&out)[4];
+    std::size_t i;
+    std::size_t n;
+};
+
+// the entry points of the SIMD kernels, everything they call is inlined and
+// compiled for their instruction set
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX512)
+template<class Kernel>
+BOOST_RANDOM_DETAIL_THREEFRY4X64_ENTRY("avx512f") void threefry4x64_run_avx512(Kernel& kernel)
+{ kernel.template run<threefry4x64_avx512_ops>(); }
+#endif
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX2)
+template<class Kernel>
+BOOST_RANDOM_DETAIL_THREEFRY4X64_ENTRY("avx2") void threefry4x64_run_avx2(Kernel& kernel)
+{ kernel.template run<threefry4x64_avx2_ops>(); }
+#endif
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_SSE2)
+template<class Kernel>
+BOOST_RANDOM_DETAIL_THREEFRY4X64_ENTRY("sse2") void threefry4x64_run_sse2(Kernel& kernel)
+{ kernel.template run<threefry4x64_sse2_ops>(); }
+#endif
+
+// the widest kernel that is compiled in and supported by the CPU
+inline threefry4x64_isa threefry4x64_detect_isa()
+{
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return threefry4x64_isa_avx512;
+    if (__builtin_cpu_supports("avx2")) return threefry4x64_isa_avx2;
+    if (__builtin_cpu_supports("sse2")) return threefry4x64_isa_sse2;
+    return threefry4x64_isa_scalar;
+#elif defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX512)
+    return threefry4x64_isa_avx512;
+#elif defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX2)
+    return threefry4x64_isa_avx2;
+#elif defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_SSE2)
+    return threefry4x64_isa_sse2;
+#else
+    return threefry4x64_isa_scalar;
+#endif
+}
+
+inline threefry4x64_isa threefry4x64_best_isa()
+{
+    static const threefry4x64_isa best = threefry4x64_detect_isa();
+    return best;
+}
+
+// the kernel used when none is forced. SSE2 has no vector rotate, and its 2
+// lanes are slower than the scalar kernel on the machines we measured, so
+// it is only used when forced.
+inline threefry4x64_isa threefry4x64_default_isa()
+{
+    const threefry4x64_isa best = threefry4x64_best_isa();
+    return best == threefry4x64_isa_sse2 ? threefry4x64_isa_scalar : best;
+}
+
+// the kernel forced with threefry4x64_force_isa(), threefry4x64_isa_auto if none
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+inline std::atomic<int>& threefry4x64_forced_isa()
+{
+    static std::atomic<int> isa(threefry4x64_isa_auto);
+    return isa;
+}
+#else
+inline int& threefry4x64_forced_isa()
+{
+    static int isa = threefry4x64_isa_auto;
+    return isa;
+}
+#endif
+
+inline threefry4x64_isa threefry4x64_active_isa()
+{
+    const int forced = threefry4x64_forced_isa();
+    return forced != threefry4x64_isa_auto ? static_cast<threefry4x64_isa>(forced) : threefry4x64_default_isa();
+}
+
+// run a kernel with the active instruction set, the widest Ops first and the narrower ones for the rest
+template<class Kernel>
+inline void threefry4x64_run(Kernel& kernel)
+{
+    const threefry4x64_isa isa = threefry4x64_active_isa();
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX512)
+    if (isa >= threefry4x64_isa_avx512) threefry4x64_run_avx512(kernel);
+#endif
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX2)
+    if (isa >= threefry4x64_isa_avx2) threefry4x64_run_avx2(kernel);
+#endif
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_SSE2)
+    if (isa == threefry4x64_isa_sse2) threefry4x64_run_sse2(kernel);
+#endif
+    (void)isa;
+    kernel.template run<threefry4x64_scalar_ops>();
+}
+
+/*
+ * Encrypts the counters ctr, ctr+1, .., ctr+n-1 with a key schedule and
+ * writes the n blocks to out. Only the first counter word is incremented,
+ * the caller must split the range where that word would carry into the
+ * next one.
+ */
+template<std::size_t Rounds>
+inline void threefry4x64_encrypt_blocks(const boost::uint_least64_t (&schedule)[Rounds/4 + 1][4], const boost::uint_least64_t (&ctr)[4], boost::uint_least64_t* out, std::size_t n)
+{
+    threefry4x64_blocks_kernel<Rounds> kernel(schedule, ctr, out, n);
+    threefry4x64_run(kernel);
+}
+
+/*
+ * Encrypts n unrelated counters, stored as 4 consecutive words each, with a
+ * key schedule and writes the n blocks to out.
+ */
+template<std::size_t Rounds>
+inline void threefry4x64_encrypt_counters(const boost::uint_least64_t (&schedule)[Rounds/4 + 1][4], const boost::uint_least64_t* ctr, boost::uint_least64_t* out, std::size_t n)
+{
+    threefry4x64_counters_kernel<Rounds> kernel(schedule, ctr, out, n);
+    threefry4x64_run(kernel);
+}
+
+// encrypts the streams i .. i+n-1, see threefry4x64_streams_kernel
+template<std::size_t Rounds>
+inline void threefry4x64_encrypt_streams(const boost::uint_least64_t* const (&key)[5], const boost::uint_least64_t* const (&ctr)[4], boost::uint_least64_t* const (&out)[4], std::size_t i, std::size_t n)
+{
+    threefry4x64_streams_kernel<Rounds> kernel(key, ctr, out, i, n);
+    threefry4x64_run(kernel);
+}
+
+} // namespace detail
+
+/**
+ * @brief Returns true if the kernel @p isa is compiled in and supported by the CPU.
+ */
+inline bool threefry4x64_isa_supported(threefry4x64_isa isa)
+{ return isa <= detail::threefry4x64_best_isa(); }
+
+/**
+ * @brief Returns the kernel that is used, the forced one or else the automatic choice.
+ */
+inline threefry4x64_isa threefry4x64_current_isa()
+{ return detail::threefry4x64_active_isa(); }
+
+/**
+ * @brief Forces the kernel @p isa for all engines, e.g. to test or benchmark
+ * every kernel on one machine. threefry4x64_isa_auto restores the automatic
+ * choice. Returns false, and changes nothing, if @p isa is not supported.
+ */
+inline bool threefry4x64_force_isa(threefry4x64_isa isa)
+{
+    if (!threefry4x64_isa_supported(isa)) return false;
+    detail::threefry4x64_forced_isa() = isa;
+    return true;
+}
+
+} // namespace random
+} // namespace boost
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_DISPATCH) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // BOOST_RANDOM_DETAIL_THREEFRY4X64_KERNEL_HPP
@@ -0,0 +1,373 @@
+/* boost random/detail/threefry_kernel.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_DETAIL_THREEFRY_KERNEL_HPP
+#define BOOST_RANDOM_DETAIL_THREEFRY_KERNEL_HPP
+
+#include <cstddef>
+#include <cstring>
+
+#include <boost/cstdint.hpp>
+#include <boost/config.hpp>
+#include <boost/random/detail/threefry4x64_kernel.hpp>
+
+// see threefry4x64_kernel.hpp
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_DISPATCH) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace boost {
+namespace random {
+namespace detail {
+
+/*
+ * The Threefry NxW round schedule of the 2x32 and 2x64 shapes, one block at
+ * a time, the 4 word shapes run threefry4_rounds of threefry4x64_kernel.hpp.
+ * The rotation constants and the parity words are the ones of Random123,
+ * the 4x64 constants are those of threefry4x64_rotation.
+ */
+
+// word type and key parity word of W bit words
+template<std::size_t WordBits> struct threefry_word;
+template<> struct threefry_word<32>
+{
+    typedef boost::uint32_t type;
+    static type parity() { return 0x1BD11BDA; }
+};
+template<> struct threefry_word<64>
+{
+    typedef boost::uint64_t type;
+    static type parity() { return 0x1BD11BDAA9FC1A22; }
+};
+
+// rotation constants of round R%8, b is only used by the 4 word shapes. The
+// primary template and the 4x64 constants are in threefry4x64_kernel.hpp.
+template<> struct threefry_rotation<2, 64, 0> { BOOST_STATIC_CONSTANT(int, a = 16); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 64, 1> { BOOST_STATIC_CONSTANT(int, a = 42); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 64, 2> { BOOST_STATIC_CONSTANT(int, a = 12); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 64, 3> { BOOST_STATIC_CONSTANT(int, a = 31); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 64, 4> { BOOST_STATIC_CONSTANT(int, a = 16); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 64, 5> { BOOST_STATIC_CONSTANT(int, a = 32); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 64, 6> { BOOST_STATIC_CONSTANT(int, a = 24); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 64, 7> { BOOST_STATIC_CONSTANT(int, a = 21); BOOST_STATIC_CONSTANT(int, b = 0); };
+
+template<> struct threefry_rotation<4, 32, 0> { BOOST_STATIC_CONSTANT(int, a = 10); BOOST_STATIC_CONSTANT(int, b = 26); };
+template<> struct threefry_rotation<4, 32, 1> { BOOST_STATIC_CONSTANT(int, a = 11); BOOST_STATIC_CONSTANT(int, b = 21); };
+template<> struct threefry_rotation<4, 32, 2> { BOOST_STATIC_CONSTANT(int, a = 13); BOOST_STATIC_CONSTANT(int, b = 27); };
+template<> struct threefry_rotation<4, 32, 3> { BOOST_STATIC_CONSTANT(int, a = 23); BOOST_STATIC_CONSTANT(int, b =  5); };
+template<> struct threefry_rotation<4, 32, 4> { BOOST_STATIC_CONSTANT(int, a =  6); BOOST_STATIC_CONSTANT(int, b = 20); };
+template<> struct threefry_rotation<4, 32, 5> { BOOST_STATIC_CONSTANT(int, a = 17); BOOST_STATIC_CONSTANT(int, b = 11); };
+template<> struct threefry_rotation<4, 32, 6> { BOOST_STATIC_CONSTANT(int, a = 25); BOOST_STATIC_CONSTANT(int, b = 10); };
+template<> struct threefry_rotation<4, 32, 7> { BOOST_STATIC_CONSTANT(int, a = 18); BOOST_STATIC_CONSTANT(int, b = 20); };
+
+template<> struct threefry_rotation<2, 32, 0> { BOOST_STATIC_CONSTANT(int, a = 13); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 32, 1> { BOOST_STATIC_CONSTANT(int, a = 15); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 32, 2> { BOOST_STATIC_CONSTANT(int, a = 26); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 32, 3> { BOOST_STATIC_CONSTANT(int, a =  6); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 32, 4> { BOOST_STATIC_CONSTANT(int, a = 17); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 32, 5> { BOOST_STATIC_CONSTANT(int, a = 29); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 32, 6> { BOOST_STATIC_CONSTANT(int, a = 16); BOOST_STATIC_CONSTANT(int, b = 0); };
+template<> struct threefry_rotation<2, 32, 7> { BOOST_STATIC_CONSTANT(int, a = 24); BOOST_STATIC_CONSTANT(int, b = 0); };
+
+template<std::size_t WordBits, int r>
+BOOST_FORCEINLINE typename threefry_word<WordBits>::type threefry_rotl(typename threefry_word<WordBits>::type x)
+{ return (x << r) | (x >> (WordBits - r)); }
+
+// one round of the 2 word shapes: mix (x0,x1)
+template<std::size_t WordBits, std::size_t R>
+struct threefry2_mix
+{
+    typedef typename threefry_word<WordBits>::type type;
+    static BOOST_FORCEINLINE void apply(type (&x)[2])
+    {
+        x[0] += x[1];
+        x[1] = threefry_rotl<WordBits, threefry_rotation<2, WordBits, R%8>::a>(x[1]) ^ x[0];
+    }
+};
+
+// subkey s: the key words ks[s..s+1] (mod 3) plus s in the last word
+template<std::size_t WordBits, std::size_t s>
+struct threefry2_inject
+{
+    typedef typename threefry_word<WordBits>::type type;
+    static BOOST_FORCEINLINE void apply(type (&x)[2], const type (&ks)[3])
+    {
+        x[0] += ks[s%3];
+        x[1] += ks[(s+1)%3] + static_cast<type>(s);
+    }
+};
+
+// rounds R..Rounds-1, forced inline so that the whole schedule is unrolled
+template<std::size_t WordBits, std::size_t Rounds, std::size_t R = 0, bool Done = (R >= Rounds)>
+struct threefry2_rounds
+{
+    typedef typename threefry_word<WordBits>::type type;
+    static BOOST_FORCEINLINE void apply(type (&x)[2], const type (&ks)[3])
+    {
+        threefry2_mix<WordBits, R>::apply(x);
+        if ((R+1)%4 == 0)
+            threefry2_inject<WordBits, (R+1)/4>::apply(x, ks);
+        threefry2_rounds<WordBits, Rounds, R+1>::apply(x, ks);
+    }
+};
+
+template<std::size_t WordBits, std::size_t Rounds, std::size_t R>
+struct threefry2_rounds<WordBits, Rounds, R, true>
+{
+    typedef typename threefry_word<WordBits>::type type;
+    static BOOST_FORCEINLINE void apply(type (&)[2], const type (&)[3]) {}
+};
+
+// encrypt one counter with the Words key words, the 4 word shapes are below
+template<std::size_t Words, std::size_t WordBits, std::size_t Rounds>
+struct threefry_block
+{
+    typedef typename threefry_word<WordBits>::type type;
+    static inline void encrypt(const type (&key)[2], type (&x)[2])
+    {
+        const type ks[3] = { key[0], key[1], threefry_word<WordBits>::parity() ^ key[0] ^ key[1] };
+        threefry2_inject<WordBits, 0>::apply(x, ks);
+        threefry2_rounds<WordBits, Rounds>::apply(x, ks);
+    }
+};
+
+template<std::size_t Words, std::size_t WordBits, std::size_t Rounds>
+inline void threefry_encrypt(const typename threefry_word<WordBits>::type (&key)[Words],
+                             typename threefry_word<WordBits>::type (&x)[Words])
+{
+    threefry_block<Words, WordBits, Rounds>::encrypt(key, x);
+}
+
+/*
+ * The Threefry4x32 kernels. The 4x32 Ops below supply the same operations
+ * as the 4x64 ones on 32 bit lanes, so the single blocks of threefry4x32
+ * and the many-blocks kernel run the one round schedule of threefry4_rounds,
+ * and the kernel goes through the instruction set dispatch of
+ * threefry4x64_run().
+ */
+
+// one block at a time
+struct threefry4x32_scalar_ops
+{
+    typedef boost::uint32_t type;
+    BOOST_STATIC_CONSTANT(std::size_t, lanes = 1);
+    BOOST_STATIC_CONSTANT(std::size_t, word_bits = 32);
+
+    static inline type set1(boost::uint32_t v) { return v; }
+    static inline type add(type a, type b) { return a + b; }
+    static inline type xor_(type a, type b) { return a ^ b; }
+    template<int r>
+    static inline type rotl(type a) { return (a << r) | (a >> (32 - r)); }
+
+    static inline type counter(boost::uint32_t c0) { return c0; }
+    static inline void store(const type (&x)[4], boost::uint32_t* out)
+    { std::memcpy(out, x, sizeof(x)); }
+};
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_SSE2)
+// 4 blocks in the 4 lanes of a 128 bit register
+struct threefry4x32_sse2_ops
+{
+    typedef __m128i type;
+    BOOST_STATIC_CONSTANT(std::size_t, lanes = 4);
+    BOOST_STATIC_CONSTANT(std::size_t, word_bits = 32);
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type set1(boost::uint32_t v) { return _mm_set1_epi32(static_cast<int>(v)); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type add(type a, type b) { return _mm_add_epi32(a, b); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type xor_(type a, type b) { return _mm_xor_si128(a, b); }
+    template<int r>
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type rotl(type a) { return _mm_or_si128(_mm_slli_epi32(a, r), _mm_srli_epi32(a, 32 - r)); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline type counter(boost::uint32_t c0)
+    { return _mm_add_epi32(set1(c0), _mm_set_epi32(3, 2, 1, 0)); }
+
+    // transpose the 4x4 words back to consecutive blocks
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("sse2") static inline void store(const type (&x)[4], boost::uint32_t* out)
+    {
+        __m128i t0 = _mm_unpacklo_epi32(x[0], x[1]);
+        __m128i t1 = _mm_unpacklo_epi32(x[2], x[3]);
+        __m128i t2 = _mm_unpackhi_epi32(x[0], x[1]);
+        __m128i t3 = _mm_unpackhi_epi32(x[2], x[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out +  0), _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out +  4), _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out +  8), _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi64(t2, t3));
+    }
+};
+#endif
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX2)
+// 8 blocks in the 8 lanes of a 256 bit register
+struct threefry4x32_avx2_ops
+{
+    typedef __m256i type;
+    BOOST_STATIC_CONSTANT(std::size_t, lanes = 8);
+    BOOST_STATIC_CONSTANT(std::size_t, word_bits = 32);
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type set1(boost::uint32_t v) { return _mm256_set1_epi32(static_cast<int>(v)); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type add(type a, type b) { return _mm256_add_epi32(a, b); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type xor_(type a, type b) { return _mm256_xor_si256(a, b); }
+    template<int r>
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type rotl(type a) { return _mm256_or_si256(_mm256_slli_epi32(a, r), _mm256_srli_epi32(a, 32 - r)); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline type counter(boost::uint32_t c0)
+    { return _mm256_add_epi32(set1(c0), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+
+    // the 4x4 transposes of the 128 bit halves give blocks 0-3 in the low
+    // and blocks 4-7 in the high halves
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx2") static inline void store(const type (&x)[4], boost::uint32_t* out)
+    {
+        __m256i t0 = _mm256_unpacklo_epi32(x[0], x[1]);
+        __m256i t1 = _mm256_unpacklo_epi32(x[2], x[3]);
+        __m256i t2 = _mm256_unpackhi_epi32(x[0], x[1]);
+        __m256i t3 = _mm256_unpackhi_epi32(x[2], x[3]);
+        __m256i b0 = _mm256_unpacklo_epi64(t0, t1);     // blocks 0 and 4
+        __m256i b1 = _mm256_unpackhi_epi64(t0, t1);     // blocks 1 and 5
+        __m256i b2 = _mm256_unpacklo_epi64(t2, t3);     // blocks 2 and 6
+        __m256i b3 = _mm256_unpackhi_epi64(t2, t3);     // blocks 3 and 7
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out +  0), _mm256_permute2x128_si256(b0, b1, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out +  8), _mm256_permute2x128_si256(b2, b3, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_permute2x128_si256(b0, b1, 0x31));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 24), _mm256_permute2x128_si256(b2, b3, 0x31));
+    }
+};
+#endif
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX512)
+// 16 blocks in the 16 lanes of a 512 bit register, using the native 32 bit
+// rotate and the masked intrinsics like threefry4x64_avx512_ops
+struct threefry4x32_avx512_ops
+{
+    typedef __m512i type;
+    BOOST_STATIC_CONSTANT(std::size_t, lanes = 16);
+    BOOST_STATIC_CONSTANT(std::size_t, word_bits = 32);
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type set1(boost::uint32_t v) { return _mm512_set1_epi32(static_cast<int>(v)); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type add(type a, type b) { return _mm512_add_epi32(a, b); }
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type xor_(type a, type b) { return _mm512_xor_si512(a, b); }
+    template<int r>
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type rotl(type a) { return _mm512_maskz_rol_epi32(0xFFFF, a, r); }
+
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline type counter(boost::uint32_t c0)
+    { return _mm512_add_epi32(set1(c0), _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)); }
+
+    // the 4x4 transposes of the 128 bit lanes give block 4*q+k in lane q of
+    // bk, the 128 bit shuffles gather lane q of b0..b3
+    BOOST_RANDOM_DETAIL_THREEFRY4X64_TARGET("avx512f") static inline void store(const type (&x)[4], boost::uint32_t* out)
+    {
+        __m512i t0 = _mm512_maskz_unpacklo_epi32(0xFFFF, x[0], x[1]);
+        __m512i t1 = _mm512_maskz_unpacklo_epi32(0xFFFF, x[2], x[3]);
+        __m512i t2 = _mm512_maskz_unpackhi_epi32(0xFFFF, x[0], x[1]);
+        __m512i t3 = _mm512_maskz_unpackhi_epi32(0xFFFF, x[2], x[3]);
+        __m512i b0 = _mm512_maskz_unpacklo_epi64(0xFF, t0, t1);
+        __m512i b1 = _mm512_maskz_unpackhi_epi64(0xFF, t0, t1);
+        __m512i b2 = _mm512_maskz_unpacklo_epi64(0xFF, t2, t3);
+        __m512i b3 = _mm512_maskz_unpackhi_epi64(0xFF, t2, t3);
+        __m512i lo01 = _mm512_maskz_shuffle_i64x2(0xFF, b0, b1, 0x44);  // lanes 0,1 of b0 and b1
+        __m512i lo23 = _mm512_maskz_shuffle_i64x2(0xFF, b2, b3, 0x44);
+        __m512i hi01 = _mm512_maskz_shuffle_i64x2(0xFF, b0, b1, 0xEE);  // lanes 2,3 of b0 and b1
+        __m512i hi23 = _mm512_maskz_shuffle_i64x2(0xFF, b2, b3, 0xEE);
+        _mm512_storeu_si512(out +  0, _mm512_maskz_shuffle_i64x2(0xFF, lo01, lo23, 0x88));
+        _mm512_storeu_si512(out + 16, _mm512_maskz_shuffle_i64x2(0xFF, lo01, lo23, 0xDD));
+        _mm512_storeu_si512(out + 32, _mm512_maskz_shuffle_i64x2(0xFF, hi01, hi23, 0x88));
+        _mm512_storeu_si512(out + 48, _mm512_maskz_shuffle_i64x2(0xFF, hi01, hi23, 0xDD));
+    }
+};
+#endif
+
+// the single block Ops of the 4 word shapes
+template<std::size_t WordBits> struct threefry4_scalar_ops;
+template<> struct threefry4_scalar_ops<32> { typedef threefry4x32_scalar_ops type; };
+template<> struct threefry4_scalar_ops<64> { typedef threefry4x64_scalar_ops type; };
+
+// the 4 word shapes add the subkeys of the key words and the parity word on the fly
+template<std::size_t WordBits, std::size_t Rounds>
+struct threefry_block<4, WordBits, Rounds>
+{
+    typedef typename threefry_word<WordBits>::type type;
+    static inline void encrypt(const type (&key)[4], type (&x)[4])
+    {
+        typedef typename threefry4_scalar_ops<WordBits>::type Ops;
+        const type ks[5] = { key[0], key[1], key[2], key[3],
+            threefry_word<WordBits>::parity() ^ key[0] ^ key[1] ^ key[2] ^ key[3] };
+        const threefry4_key<Ops> k(ks);
+        k.template inject<0>(x);
+        threefry4_rounds<Ops, Rounds>::apply(x, k);
+    }
+};
+
+// the 4x32 Ops of the instruction set of the 4x64 Ops that threefry4x64_run() passes
+template<class Ops> struct threefry4x32_ops;
+template<> struct threefry4x32_ops<threefry4x64_scalar_ops> { typedef threefry4x32_scalar_ops type; };
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_SSE2)
+template<> struct threefry4x32_ops<threefry4x64_sse2_ops> { typedef threefry4x32_sse2_ops type; };
+#endif
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX2)
+template<> struct threefry4x32_ops<threefry4x64_avx2_ops> { typedef threefry4x32_avx2_ops type; };
+#endif
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_AVX512)
+template<> struct threefry4x32_ops<threefry4x64_avx512_ops> { typedef threefry4x32_avx512_ops type; };
+#endif
+
+// the n counters ctr, ctr+1, .., the increment only touches the first counter word
+template<std::size_t Rounds>
+struct threefry4x32_blocks_kernel
+{
+    threefry4x32_blocks_kernel(const boost::uint32_t (&s)[Rounds/4 + 1][4], const boost::uint32_t (&c)[4], boost::uint32_t* o, std::size_t count)
+    : schedule(s), out(o), n(count)
+    {
+        for (std::size_t i=0; i<4; ++i)
+            ctr[i] = c[i];
+    }
+
+    template<class Ops64>
+    inline void run()
+    {
+        typedef typename threefry4x32_ops<Ops64>::type Ops;
+        if (n < Ops::lanes) return;
+        const threefry4_expanded_key<Ops, Rounds> key(schedule);
+        for (; n >= Ops::lanes; n -= Ops::lanes) {
+            threefry4_encrypt_lanes<Rounds, Ops>(key, ctr, out);
+            ctr[0] += static_cast<boost::uint32_t>(Ops::lanes);
+            out += 4*Ops::lanes;
+        }
+    }
+
+    const boost::uint32_t (&schedule)[Rounds/4 + 1][4];
+    boost::uint32_t ctr[4];
+    boost::uint32_t* out;
+    std::size_t n;
+};
+
+/*
+ * Encrypts the Threefry4x32 counters ctr, ctr+1, .., ctr+n-1 with a key
+ * schedule and writes the n blocks to out. Only the first counter word is
+ * incremented, the caller must split the range where that word would carry
+ * into the next one.
+ */
+template<std::size_t Rounds>
+inline void threefry4x32_encrypt_blocks(const boost::uint32_t (&schedule)[Rounds/4 + 1][4], const boost::uint32_t (&ctr)[4], boost::uint32_t* out, std::size_t n)
+{
+    threefry4x32_blocks_kernel<Rounds> kernel(schedule, ctr, out, n);
+    threefry4x64_run(kernel);
+}
+
+} // namespace detail
+} // namespace random
+} // namespace boost
+
+#if defined(BOOST_RANDOM_DETAIL_THREEFRY4X64_DISPATCH) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // BOOST_RANDOM_DETAIL_THREEFRY_KERNEL_HPP
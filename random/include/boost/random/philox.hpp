@@ -0,0 +1,162 @@
+/* boost random/philox.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_PHILOX_HPP
+#define BOOST_RANDOM_PHILOX_HPP
+
+#include <cstddef>
+
+#include <boost/array.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/config.hpp>
+#include <boost/static_assert.hpp>
+
+#include <boost/random/counter_based_engine.hpp>
+
+namespace boost {
+namespace random {
+
+namespace detail {
+
+    // multipliers and Weyl key increments of Philox4xW
+    template<std::size_t WordBits> struct philox4_constants;
+    template<> struct philox4_constants<32>
+    {
+        typedef boost::uint32_t type;
+        static type m0() { return 0xD2511F53; }
+        static type m1() { return 0xCD9E8D57; }
+        static type w0() { return 0x9E3779B9; }
+        static type w1() { return 0xBB67AE85; }
+
+        // the high and low half of the 64 bit product a*b
+        static BOOST_FORCEINLINE type mulhilo(type a, type b, type& hi)
+        {
+            const boost::uint64_t p = static_cast<boost::uint64_t>(a) * b;
+            hi = static_cast<type>(p >> 32);
+            return static_cast<type>(p);
+        }
+    };
+    template<> struct philox4_constants<64>
+    {
+        typedef boost::uint64_t type;
+        static type m0() { return 0xD2E7470EE14C6C93; }
+        static type m1() { return 0xCA5A826395121157; }
+        static type w0() { return 0x9E3779B97F4A7C15; }
+        static type w1() { return 0xBB67AE8584CAA73B; }
+
+        // the high and low half of the 128 bit product a*b
+        static BOOST_FORCEINLINE type mulhilo(type a, type b, type& hi)
+        {
+#ifdef BOOST_HAS_INT128
+            const boost::uint128_type p = static_cast<boost::uint128_type>(a) * b;
+            hi = static_cast<type>(p >> 64);
+            return static_cast<type>(p);
+#else
+            const type a0 = a & 0xFFFFFFFF, a1 = a >> 32;
+            const type b0 = b & 0xFFFFFFFF, b1 = b >> 32;
+            const type p00 = a0*b0, p01 = a0*b1, p10 = a1*b0, p11 = a1*b1;
+            const type mid = (p00 >> 32) + (p01 & 0xFFFFFFFF) + (p10 & 0xFFFFFFFF);
+            hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+            return a*b;
+#endif
+        }
+    };
+
+    // rounds R..Rounds-1, the key is bumped before every round but the first
+    template<std::size_t WordBits, std::size_t Rounds, std::size_t R = 0, bool Done = (R >= Rounds)>
+    struct philox4_rounds
+    {
+        typedef philox4_constants<WordBits> constants;
+        typedef typename constants::type type;
+        static BOOST_FORCEINLINE void apply(type (&x)[4], type k0, type k1)
+        {
+            if (R > 0) {
+                k0 += constants::w0();
+                k1 += constants::w1();
+            }
+            type hi0, hi1;
+            const type lo0 = constants::mulhilo(constants::m0(), x[0], hi0);
+            const type lo1 = constants::mulhilo(constants::m1(), x[2], hi1);
+            x[0] = hi1 ^ x[1] ^ k0;
+            x[1] = lo1;
+            x[2] = hi0 ^ x[3] ^ k1;
+            x[3] = lo0;
+            philox4_rounds<WordBits, Rounds, R+1>::apply(x, k0, k1);
+        }
+    };
+
+    template<std::size_t WordBits, std::size_t Rounds, std::size_t R>
+    struct philox4_rounds<WordBits, Rounds, R, true>
+    {
+        typedef typename philox4_constants<WordBits>::type type;
+        static BOOST_FORCEINLINE void apply(type (&)[4], type, type) {}
+    };
+
+    // the keyed Philox4xW bijection
+    template<std::size_t WordBits, std::size_t Rounds>
+    struct philox4_cipher
+    {
+        BOOST_STATIC_ASSERT( Rounds>=1 );
+
+        typedef typename philox4_constants<WordBits>::type word_type;
+        typedef boost::array<word_type, 2> key_type;
+        typedef boost::array<word_type, 4> ctr_type;
+        BOOST_STATIC_CONSTANT(std::size_t, word_bits = WordBits);
+        BOOST_STATIC_CONSTANT(std::size_t, rounds = Rounds);
+
+        static ctr_type encrypt(const key_type& key, const ctr_type& ctr) BOOST_NOEXCEPT
+        {
+            word_type x[4] = { ctr[0], ctr[1], ctr[2], ctr[3] };
+            philox4_rounds<WordBits, Rounds>::apply(x, key[0], key[1]);
+
+            ctr_type out = {{ x[0], x[1], x[2], x[3] }};
+            return out;
+        }
+    };
+
+} // detail
+
+/**
+* @brief The keyed Philox4x32 bijection: a 64 bit key and a 128 bit counter give a 128 bit block.
+*
+* Philox replaces the add-rotate-xor rounds of Threefry by 32x32->64 bit
+* multiplications, which is faster on cores with a fast wide multiplier.
+*
+* parameter @p Rounds the number of rounds, 10 in Random123. Must be 1 or higher.
+*/
+template <std::size_t Rounds = 10>
+struct philox4x32 : detail::philox4_cipher<32, Rounds> {};
+
+/**
+* @brief The keyed Philox4x64 bijection: a 128 bit key and a 256 bit counter give a 256 bit block.
+*
+* Uses 64x64->128 bit multiplications.
+*
+* parameter @p Rounds the number of rounds, 10 in Random123. Must be 1 or higher.
+*/
+template <std::size_t Rounds = 10>
+struct philox4x64 : detail::philox4_cipher<64, Rounds> {};
+
+/**
+ * 32 bit version of the 10 rounds philox4x32 engine, 64 bit seed, 2^130 cycle length
+ */
+typedef counter_based_engine<boost::uint32_t, 32, philox4x32<10> > philox4x32_10;
+
+/**
+ * 64 bit version of the 10 rounds philox4x64 engine, 128 bit seed, 2^258 cycle length
+ */
+typedef counter_based_engine<boost::uint64_t, 64, philox4x64<10> > philox4x64_10_64;
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_PHILOX_HPP
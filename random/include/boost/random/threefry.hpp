@@ -0,0 +1,154 @@
+/* boost random/threefry.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_THREEFRY_HPP
+#define BOOST_RANDOM_THREEFRY_HPP
+
+#include <cstddef>
+
+#include <boost/array.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/config.hpp>
+#include <boost/static_assert.hpp>
+
+#include <boost/random/counter_based_engine.hpp>
+#include <boost/random/detail/threefry_kernel.hpp>
+
+namespace boost {
+namespace random {
+
+namespace detail {
+
+    // the keyed Threefry bijection of Words words of WordBits bits
+    template<std::size_t Words, std::size_t WordBits, std::size_t Rounds>
+    struct threefry_cipher
+    {
+        BOOST_STATIC_ASSERT( Rounds>=1 );
+
+        typedef typename threefry_word<WordBits>::type word_type;
+        typedef boost::array<word_type, Words> key_type;
+        typedef boost::array<word_type, Words> ctr_type;
+        BOOST_STATIC_CONSTANT(std::size_t, word_bits = WordBits);
+        BOOST_STATIC_CONSTANT(std::size_t, rounds = Rounds);
+
+        static ctr_type encrypt(const key_type& key, const ctr_type& ctr) BOOST_NOEXCEPT
+        {
+            word_type k[Words];
+            word_type x[Words];
+            for (std::size_t i=0; i<Words; ++i) {
+                k[i] = key[i];
+                x[i] = ctr[i];
+            }
+            threefry_encrypt<Words, WordBits, Rounds>(k, x);
+
+            ctr_type out;
+            for (std::size_t i=0; i<Words; ++i)
+                out[i] = x[i];
+            return out;
+        }
+    };
+
+} // detail
+
+/**
+* @brief The keyed Threefry2x64 bijection: a 128 bit key and counter give a 128 bit block.
+*
+* parameter @p Rounds the number of encryption rounds. Must be 1 or higher.
+*/
+template <std::size_t Rounds = 20>
+struct threefry2x64 : detail::threefry_cipher<2, 64, Rounds> {};
+
+/**
+* @brief The keyed Threefry4x32 bijection: a 128 bit key and counter give a 128 bit block.
+*
+* parameter @p Rounds the number of encryption rounds. Must be 1 or higher.
+*/
+template <std::size_t Rounds = 20>
+struct threefry4x32 : detail::threefry_cipher<4, 32, Rounds> {};
+
+namespace detail {
+
+    // threefry4x32 blocks with the lanes of the SIMD kernels
+    template<std::size_t Rounds>
+    struct cipher_blocks< threefry4x32<Rounds> >
+    {
+        static void encrypt(const typename threefry4x32<Rounds>::key_type& key, typename threefry4x32<Rounds>::ctr_type ctr,
+                            boost::uint32_t* out, std::size_t n)
+        {
+            const boost::uint32_t ks[5] = { key[0], key[1], key[2], key[3],
+                threefry_word<32>::parity() ^ key[0] ^ key[1] ^ key[2] ^ key[3] };
+            boost::uint32_t schedule[Rounds/4 + 1][4];
+            threefry4_expand_key<Rounds>(ks, schedule);
+
+            boost::uint32_t c[4] = { ctr[0], ctr[1], ctr[2], ctr[3] };
+            while (n > 0) {
+                // the kernel only increments the first counter word
+                std::size_t m = n;
+                if (static_cast<boost::uint32_t>(~c[0]) < m - 1)
+                    m = static_cast<std::size_t>(static_cast<boost::uint32_t>(~c[0])) + 1;
+
+                threefry4x32_encrypt_blocks<Rounds>(schedule, c, out, m);
+                out += 4*m;
+                n -= m;
+
+                // add m with carry
+                c[0] += static_cast<boost::uint32_t>(m);
+                for (std::size_t i=1; i<4 && c[i-1] == 0; ++i)
+                    ++c[i];
+            }
+        }
+    };
+
+} // detail
+
+/**
+* @brief The keyed Threefry2x32 bijection: a 64 bit key and counter give a 64 bit block.
+*
+* parameter @p Rounds the number of encryption rounds. Must be 1 or higher.
+*/
+template <std::size_t Rounds = 20>
+struct threefry2x32 : detail::threefry_cipher<2, 32, Rounds> {};
+
+/**
+ * 64 bit version of the 13 rounds threefry2x64 engine, 128 bit seed, 2^129 cycle length
+ */
+typedef counter_based_engine<boost::uint64_t, 64, threefry2x64<13> > threefry2x64_13_64;
+
+/**
+ * 64 bit version of the 20 rounds threefry2x64 engine, 128 bit seed, 2^129 cycle length
+ */
+typedef counter_based_engine<boost::uint64_t, 64, threefry2x64<20> > threefry2x64_20_64;
+
+/**
+ * 32 bit version of the 13 rounds threefry4x32 engine, 128 bit seed, 2^130 cycle length
+ */
+typedef counter_based_engine<boost::uint32_t, 32, threefry4x32<13> > threefry4x32_13;
+
+/**
+ * 32 bit version of the 20 rounds threefry4x32 engine, 128 bit seed, 2^130 cycle length
+ */
+typedef counter_based_engine<boost::uint32_t, 32, threefry4x32<20> > threefry4x32_20;
+
+/**
+ * 32 bit version of the 13 rounds threefry2x32 engine, 64 bit seed, 2^65 cycle length
+ */
+typedef counter_based_engine<boost::uint32_t, 32, threefry2x32<13> > threefry2x32_13;
+
+/**
+ * 32 bit version of the 20 rounds threefry2x32 engine, 64 bit seed, 2^65 cycle length
+ */
+typedef counter_based_engine<boost::uint32_t, 32, threefry2x32<20> > threefry2x32_20;
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_THREEFRY_HPP
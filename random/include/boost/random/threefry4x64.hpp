@@ -14,17 +14,33 @@
 #define BOOST_RANDOM_THREEFRY4X64_HPP
 #include <istream>
 #include <algorithm>
+#include <climits>
+#include <cstring>
 
+#if __cplusplus >= 202002L && defined(__has_include)
+#  if __has_include(<span>)
+#    include <cstddef>
+#    include <span>
+#    define BOOST_RANDOM_THREEFRY4X64_HAS_SPAN
+#  endif
+#endif
+
+#include <boost/array.hpp>
 #include <boost/cstdint.hpp>
 #include <boost/config.hpp>
 #include <boost/limits.hpp>
+#include <boost/assert.hpp>
+#include <boost/predef/other/endian.h>
 
 #include <boost/static_assert.hpp>
+#include <boost/type_traits/integral_constant.hpp>
 
 #include <boost/random/detail/config.hpp>
 #include <boost/random/detail/const_mod.hpp>
 #include <boost/random/detail/seed.hpp>
 #include <boost/random/detail/seed_impl.hpp>
+#include <boost/random/detail/counter_state.hpp>
+#include <boost/random/detail/threefry4x64_kernel.hpp>
 
 
 namespace boost {
@@ -66,7 +82,7 @@ namespace detail {
         inline static UIntType zth(const boost::uint_least64_t (&_output)[4])
             { return _output[0] & 0xFFFF; }
         inline static UIntType nth(const boost::uint_least64_t (&_output)[4], std::size_t n)
-            { return (_output[n>>2] >> ((n&11)<<4)) & 0xFFFF; }
+            { return (_output[n>>2] >> ((n&3)<<4)) & 0xFFFF; }
         inline static UIntType w_max()
             { return 0xFFFF; }
     };
@@ -75,12 +91,232 @@ namespace detail {
         inline static UIntType zth(const boost::uint_least64_t (&_output)[4])
             { return _output[0] & 0xFF; }
         inline static UIntType nth(const boost::uint_least64_t (&_output)[4], std::size_t n)
-            { return (_output[n>>3] >> ((n&111)<<3)) & 0xFF; }
+            { return (_output[n>>3] >> ((n&7)<<3)) & 0xFF; }
         inline static UIntType w_max()
             { return 0xFF; }
     };
+
+    // all 256/w values of a block in one go, value n holds the bits [n*w, n*w+w)
+    // of the block, i.e. the little endian byte order of the 64 bit words
+    template< typename UIntType, std::size_t w>
+    inline void extract4x64_unpack(const boost::uint_least64_t* block, UIntType* out)
+    {
+#if BOOST_ENDIAN_LITTLE_BYTE
+        if (sizeof(UIntType)*CHAR_BIT == w && sizeof(boost::uint_least64_t)*CHAR_BIT == 64) {
+            std::memcpy(out, block, 32);
+            return;
+        }
+#endif
+        const std::size_t per_word = 64 / w;
+        for (std::size_t j=0; j<4; ++j)
+            for (std::size_t k=0; k<per_word; ++k)
+                out[j*per_word + k] = static_cast<UIntType>((block[j] >> (k*w)) & extract4x64_impl<UIntType,w>::w_max());
+    }
+
+    // the bytes [first, first+count) of a sequence of blocks, little endian
+    inline void extract4x64_bytes(const boost::uint_least64_t* blocks, std::size_t first, std::size_t count, unsigned char* out)
+    {
+#if BOOST_ENDIAN_LITTLE_BYTE
+        if (sizeof(boost::uint_least64_t)*CHAR_BIT == 64) {
+            std::memcpy(out, reinterpret_cast<const unsigned char*>(blocks) + first, count);
+            return;
+        }
+#endif
+        for (std::size_t i=first; i<first+count; ++i)
+            *out++ = static_cast<unsigned char>((blocks[i>>3] >> ((i&7)<<3)) & 0xFF);
+    }
+
+    // a 64 bit word as 8 little endian bytes, and back
+    inline void threefry4x64_store_le(unsigned char* p, boost::uint_least64_t x)
+    {
+        for (std::size_t i=0; i<8; ++i)
+            p[i] = static_cast<unsigned char>((x >> (8*i)) & 0xFF);
+    }
+    inline boost::uint_least64_t threefry4x64_load_le(const unsigned char* p)
+    {
+        boost::uint_least64_t x = 0;
+        for (std::size_t i=0; i<8; ++i)
+            x |= static_cast<boost::uint_least64_t>(p[i]) << (8*i);
+        return x;
+    }
+
+    // an empty base that gives the engine the alignment of its layout
+    template<std::size_t Alignment>
+    struct threefry4x64_aligned {};
+    template<>
+    struct BOOST_ALIGNMENT(32) threefry4x64_aligned<32> {};
+    template<>
+    struct BOOST_ALIGNMENT(64) threefry4x64_aligned<64> {};
+
+    // the output block of the engine, a base so it comes first and is
+    // aligned when the engine is
+    template<bool OutputCache>
+    struct threefry4x64_output_cache
+    {
+        boost::uint_least64_t _output[4];   // the 256 bit cipher output 4 * 64 bit = 256 bit output
+    };
+    template<>
+    struct threefry4x64_output_cache<false> {};
 } // detail
 
+/**
+* @brief The memory layout of a %threefry4x64_engine.
+*
+* parameter @p Alignment 0 for the natural alignment of the engine, 32 or 64 to
+* align engines to 32 byte SIMD registers or 64 byte cache lines, so arrays of
+* engines don't straddle cache lines.
+* parameter @p OutputCache false to only store the key, the counter and the offset:
+* every value is then computed by encrypting its block again, which is slower but
+* saves the 32 byte output block per engine.
+*
+* The layout doesn't change the values of the engine, and save() and load()
+* exchange states between engines with different layouts.
+*/
+template <std::size_t Alignment = 0, bool OutputCache = true>
+struct threefry4x64_layout
+{
+    BOOST_STATIC_ASSERT( Alignment==0 || Alignment==32 || Alignment==64 );
+
+    BOOST_STATIC_CONSTANT(std::size_t, alignment = Alignment);
+    BOOST_STATIC_CONSTANT(bool, output_cache = OutputCache);
+};
+
+/**
+* @brief The keyed Threefry4x64 bijection that the %threefry4x64_engine is built on.
+*
+* encrypt() maps a 256 bit counter to a 256 bit output block with a 256 bit key.
+* It has no state, so any block of any stream can be computed directly from its
+* key and counter, e.g. by workers that each need a different part of a stream.
+*
+* parameter @p Rounds the number of encryption rounds. Must be 1 or higher.
+*
+* The output of encrypt(key, ctr) is the block a %threefry4x64_engine with the
+* same number of rounds, seeded with @p key, produces for counter @p ctr. It can
+* also be used as the cipher of a counter_based_engine.
+*/
+template <std::size_t Rounds = 20>
+struct threefry4x64
+{
+    BOOST_STATIC_ASSERT( Rounds>=1 );
+
+    typedef boost::uint_least64_t word_type;
+    typedef boost::array<boost::uint_least64_t, 4> key_type;
+    typedef boost::array<boost::uint_least64_t, 4> ctr_type;
+    BOOST_STATIC_CONSTANT(std::size_t, word_bits = 64);
+    BOOST_STATIC_CONSTANT(std::size_t, rounds = Rounds);
+
+    /**
+     * @brief Encrypts the counter @p ctr with the key @p key.
+     *
+     * A constant expression in C++14 and later, e.g. for tables of random
+     * values that are computed at compile time.
+     */
+    static BOOST_CXX14_CONSTEXPR ctr_type encrypt(const key_type& key, const ctr_type& ctr) BOOST_NOEXCEPT
+    {
+        // elems, the operator[] of boost::array is not constexpr in all versions
+        const detail::threefry4x64_word_key k = {{ key.elems[0], key.elems[1], key.elems[2], key.elems[3],
+            detail::threefry4x64_tweak ^ key.elems[0] ^ key.elems[1] ^ key.elems[2] ^ key.elems[3] }};
+        boost::uint_least64_t x[4] = { ctr.elems[0], ctr.elems[1], ctr.elems[2], ctr.elems[3] };
+        detail::threefry4x64_encrypt_words<Rounds>(k, x);
+
+        const ctr_type out = {{ x[0], x[1], x[2], x[3] }};
+        return out;
+    }
+};
+
+template<typename UIntType, std::size_t ReturnBits, std::size_t Rounds, std::size_t KeySize, std::size_t CounterSize, class Layout>
+class threefry4x64_engine;
+
+/**
+* @brief The expanded key of the Threefry4x64 bijection.
+*
+* Threefry adds a subkey to the block after every 4 rounds. The subkeys only
+* depend on the key, and the key schedule computes all Rounds/4+1 of them once.
+* The schedule is immutable after construction and can be shared by any number
+* of threads.
+*
+* parameter @p Rounds the number of encryption rounds. Must be 1 or higher.
+*/
+template <std::size_t Rounds = 20>
+class threefry4x64_key_schedule
+{
+public:
+    typedef typename threefry4x64<Rounds>::key_type key_type;
+    typedef typename threefry4x64<Rounds>::ctr_type ctr_type;
+    BOOST_STATIC_CONSTANT(std::size_t, rounds = Rounds);
+    BOOST_STATIC_CONSTANT(std::size_t, subkeys = Rounds/4 + 1);
+
+    /**
+     * @brief Computes the key schedule of @p key.
+     */
+    explicit threefry4x64_key_schedule(const key_type& key)
+    {
+        const boost::uint_least64_t ks[5] = { key[0], key[1], key[2], key[3],
+            detail::threefry4x64_tweak ^ key[0] ^ key[1] ^ key[2] ^ key[3] };
+        detail::threefry4_expand_key<Rounds>(ks, _schedule);
+    }
+
+    /**
+     * @brief Encrypts the counter @p ctr, same as threefry4x64<Rounds>::encrypt(key, ctr).
+     */
+    ctr_type encrypt(const ctr_type& ctr) const BOOST_NOEXCEPT
+    {
+        const boost::uint_least64_t c[4] = { ctr[0], ctr[1], ctr[2], ctr[3] };
+        
+        ctr_type out;
+        detail::threefry4x64_encrypt<Rounds>(_schedule, c, out.data());
+        return out;
+    }
+
+    /**
+     * @brief Encrypts the @p n counters @p ctr, @p ctr+1, .. and writes the blocks
+     * as 4 consecutive 64 bit words each to @p out.
+     */
+    void encrypt_blocks(const ctr_type& ctr, boost::uint_least64_t* out, std::size_t n) const
+    {
+        boost::uint_least64_t c[4] = { ctr[0], ctr[1], ctr[2], ctr[3] };
+        while (n > 0) {
+            // the kernel only increments the first counter word
+            std::size_t m = n;
+            if (~c[0] < m - 1)
+                m = static_cast<std::size_t>(~c[0]) + 1;
+            
+            detail::threefry4x64_encrypt_blocks<Rounds>(_schedule, c, out, m);
+            out += 4*m;
+            n -= m;
+
+            // add m with carry
+            c[0] += m;
+            for (std::size_t i=1; i<4 && c[i-1] == 0; ++i)
+                ++c[i];
+        }
+    }
+
+    /**
+     * @brief Encrypts the unrelated counters [@p first, @p last) and writes
+     * their blocks to @p out, same as calling encrypt() for each of them.
+     */
+    void encrypt(const ctr_type* first, const ctr_type* last, ctr_type* out) const
+    {
+        BOOST_STATIC_ASSERT( sizeof(ctr_type) == 4*sizeof(boost::uint_least64_t) );
+        if (first == last) return;
+        detail::threefry4x64_encrypt_counters<Rounds>(_schedule, first->data(), out->data(), static_cast<std::size_t>(last - first));
+    }
+
+    /**
+     * @brief Returns subkey @p s, word @p i.
+     */
+    boost::uint_least64_t subkey(std::size_t s, std::size_t i) const
+    { return _schedule[s][i]; }
+
+private:
+    // the engines encrypt their own counters with the subkeys
+    template<typename, std::size_t, std::size_t, std::size_t, std::size_t, class>
+    friend class threefry4x64_engine;
+
+    boost::uint_least64_t _schedule[subkeys][4];
+};
+
 /**
 * @brief The threefry random engine is a counter based random engine that uses a stripped-down Threefish cryptographic function that is optimised for speed.
 *
@@ -89,6 +325,7 @@ namespace detail {
 * parameter @p Rounds the number of encryption rounds. Must be 1 or higher.
 * parameter @p KeySize the number of 64bit integers in the key. The key value is set via a seed, and different keys give different random sequences. The default value is 4, valida values are 0,1,2,3,4. The number of independent seed valuedsis 2^( 64*KeySize ).
 * parameter @p CounterSize the number of 64bit integers in the internal counter. The default value is 4, valid values are 1,2,3,4. The cycle of the engine is  2^( 64*CounterSize + S ) with S=3 for a 32 bit random engine, and S=2 for a 64 bit random engine.
+* parameter @p Layout the memory layout of the engine, a threefry4x64_layout.
 *
 * @blockquote
 * title:     Parallel random numbers: as easy as 1, 2, 3
@@ -111,9 +348,12 @@ template <  typename UIntType,
             std::size_t ReturnBits,
             std::size_t Rounds = 20,
             std::size_t KeySize = 4,
-            std::size_t CounterSize = 4
+            std::size_t CounterSize = 4,
+            class Layout = threefry4x64_layout<>
         >
 class threefry4x64_engine
+    : private detail::threefry4x64_aligned<Layout::alignment>
+    , private detail::threefry4x64_output_cache<Layout::output_cache>
 {
 public:
     BOOST_STATIC_ASSERT( ReturnBits==8 || ReturnBits==16 || ReturnBits==32 || ReturnBits==64 );
@@ -127,6 +367,25 @@ public:
     BOOST_STATIC_CONSTANT(bool, has_fixed_range = false);
 
     BOOST_STATIC_CONSTANT(std::size_t, samples_per_block = 256/ReturnBits);
+
+    /**
+     * The number of most significant counter bits that select a stream, see seek_stream().
+     * The remaining 64*CounterSize-stream_bits counter bits count the blocks within a stream.
+     */
+    BOOST_STATIC_CONSTANT(std::size_t, stream_bits = (CounterSize > 1 ? 64 : 32));
+
+    /**
+     * An absolute position in the sequence of values, blocks * samples_per_block + offset,
+     * as CounterSize+1 little endian 64 bit words. Positions are taken modulo the cycle
+     * length of samples_per_block * 2^(64*CounterSize) values.
+     */
+    typedef boost::array<boost::uint_least64_t, CounterSize + 1> position_type;
+
+    /** A 256 bit encrypted block as 4 64 bit words, see next_block(). */
+    typedef boost::array<boost::uint_least64_t, 4> block_type;
+
+    /** The expanded key of the engine, see key_schedule(). */
+    typedef threefry4x64_key_schedule<Rounds> key_schedule_type;
     
     /**
      * @brief Constructs the defafult %threefry4x64_engine.
@@ -236,17 +495,7 @@ public:
      * @brief Generate a random sample.
      */
     result_type operator()()
-    {
-        // can we return a value from the current block?
-        if (_o_counter < samples_per_block)
-            return detail::extract4x64_impl<UIntType,ReturnBits>::nth(_output, _o_counter++);
-        
-        // generate a new block and return the first result_type 
-        inc_counter();
-        encrypt_counter();
-        _o_counter = 1; // the next call
-        return detail::extract4x64_impl<UIntType,ReturnBits>::zth(_output);
-    }
+    { return next(has_output_cache()); }
 
     /**
      * @brief Fills a range with random values.
@@ -254,32 +503,335 @@ public:
     template<class Iter>
     void generate(Iter first, Iter last)
     { detail::generate_from_int(*this, first, last); }
-    
+
     /**
-     * @brief Discard a number of elements from the random numbers sequence.
+     * @brief Fills a contiguous range with random values.
      *
-     * @param z the number of elements to discard.
+     * Produces the same 32 bit words as the generic iterator version, but
+     * encrypts the full blocks in the middle of the range in a tight loop
+     * instead of going through operator() for every value.
      */
-    void discard(boost::uintmax_t z)
+    template<class T>
+    void generate(T* first, T* last)
     {
-        // check if we stay in the current block
-        if (z <= samples_per_block - _o_counter) {
-            _o_counter += static_cast<unsigned short>(z);
+        boost::uint_least64_t current[4];
+        const boost::uint_least64_t* block = current_block(current);
+        
+        // the 32 bit word stream must start at a word boundary in the current block
+        if ((_o_counter * ReturnBits) % 32 != 0) {
+            detail::generate_from_int(*this, first, last);
+            return;
+        }
+
+        std::size_t n = static_cast<std::size_t>(last - first);
+        if (n == 0) return;
+
+        // head: the unused words of the current block
+        std::size_t w = (_o_counter * ReturnBits) / 32;
+        while (n > 0 && w < 8) {
+            *first++ = word32(block, w++);
+            --n;
+        }
+        if (n == 0) {
+            _o_counter = static_cast<boost::uint_least16_t>((w*32 + ReturnBits - 1) / ReturnBits);
             return;
         }
+        _o_counter = samples_per_block;
+
+        // body: full blocks, the key is expanded once for all of them
+        if (n >= 8) {
+            const key_schedule_type schedule = key_schedule();
+            boost::uint_least64_t buffer[4*bulk_blocks];
+            do {
+                std::size_t nblocks = (std::min)(n/8, static_cast<std::size_t>(bulk_blocks));
+                generate_blocks(schedule, buffer, nblocks);
+                for (std::size_t i=0; i<8*nblocks; ++i)
+                    *first++ = word32(buffer, i);
+                n -= 8*nblocks;
+            } while (n >= 8);
+        }
+
+        // tail: part of a new block
+        if (n > 0) {
+            inc_counter();
+            _o_counter = lazy_flag;
+            block = current_block(current);
+            for (w=0; w<n; ++w)
+                *first++ = word32(block, w);
+        }
+        
+        // a partially used result_type counts as consumed
+        _o_counter = static_cast<boost::uint_least16_t>((w*32 + ReturnBits - 1) / ReturnBits);
+    }
+
+    /**
+     * @brief Fills [@p first, @p last) with the values that successive calls
+     * of operator() would return.
+     *
+     * Full blocks are split into their samples_per_block values in one go
+     * instead of a shift and mask per call, which mostly pays off for 8 and
+     * 16 bit engines, e.g. when filling large byte buffers.
+     */
+    void fill(result_type* first, result_type* last)
+    {
+        std::size_t n = static_cast<std::size_t>(last - first);
+
+        // head: the rest of a partially consumed block
+        while (n > 0 && block_offset() % samples_per_block != 0) {
+            *first++ = (*this)();
+            --n;
+        }
 
-        _o_counter += (z % samples_per_block);
-         z /= samples_per_block;
-         
-         if (_o_counter > samples_per_block) {
-            _o_counter -= samples_per_block;
-            ++z;
-         }
-         
-        inc_counter(z);
+        // body: full blocks, the key is expanded once for all of them
+        if (n >= samples_per_block) {
+            const key_schedule_type schedule = key_schedule();
+            boost::uint_least64_t buffer[4*bulk_blocks];
+            do {
+                std::size_t nblocks = (std::min)(n/samples_per_block, static_cast<std::size_t>(bulk_blocks));
+                generate_blocks(schedule, buffer, nblocks);
+                for (std::size_t i=0; i<nblocks; ++i) {
+                    detail::extract4x64_unpack<UIntType,ReturnBits>(buffer + 4*i, first);
+                    first += samples_per_block;
+                }
+                n -= nblocks*samples_per_block;
+            } while (n >= samples_per_block);
+        }
+
+        // tail: part of a new block
+        while (n > 0) {
+            *first++ = (*this)();
+            --n;
+        }
+    }
+
+    /**
+     * @brief Writes @p n random bytes to @p dst.
+     *
+     * The bytes are the little endian bytes of the values that successive
+     * calls of operator() would return, so byte and value draws can be
+     * mixed freely. A partially used value counts as consumed. Full blocks
+     * are encrypted straight into @p dst when it is 8 byte aligned.
+     */
+    void fill_bytes(void* dst, std::size_t n)
+    {
+        unsigned char* out = static_cast<unsigned char*>(dst);
         
-        if (_o_counter != samples_per_block)
-            encrypt_counter();
+        // head: the rest of a partially consumed block
+        if (n > 0 && block_offset() % samples_per_block != 0) {
+            boost::uint_least64_t buffer[4];
+            const boost::uint_least64_t* block = current_block(buffer);
+            const std::size_t b = block_offset() * ReturnBits / 8;
+            const std::size_t m = (std::min)(n, 32 - b);
+            detail::extract4x64_bytes(block, b, m, out);
+            out += m;
+            n -= m;
+            _o_counter = static_cast<boost::uint_least16_t>(((b + m)*8 + ReturnBits - 1) / ReturnBits);
+        }
+        if (n == 0) return;
+
+        // body: full blocks, the key is expanded once for all of them
+        if (n >= 32) {
+            const key_schedule_type schedule = key_schedule();
+            do {
+                std::size_t nblocks = (std::min)(n/32, static_cast<std::size_t>(byte_blocks));
+#if BOOST_ENDIAN_LITTLE_BYTE
+                // the kernels only write through memcpy and SIMD stores, never
+                // through a uint_least64_t lvalue, so the bytes may be of any type
+                if (reinterpret_cast<boost::uintptr_t>(out) % sizeof(boost::uint_least64_t) == 0) {
+                    nblocks = n/32;
+                    generate_blocks(schedule, reinterpret_cast<boost::uint_least64_t*>(out), nblocks);
+                } else
+#endif
+                {
+                    boost::uint_least64_t buffer[4*byte_blocks];
+                    generate_blocks(schedule, buffer, nblocks);
+                    detail::extract4x64_bytes(buffer, 0, 32*nblocks, out);
+                }
+                out += 32*nblocks;
+                n -= 32*nblocks;
+            } while (n >= 32);
+        }
+
+        // tail: part of a new block, a single block doesn't need the schedule
+        if (n > 0) {
+            boost::uint_least64_t buffer[4];
+            boost::uint_least64_t* block = block_buffer(buffer);
+            generate_blocks(block, 1);
+            detail::extract4x64_bytes(block, 0, n, out);
+            _o_counter = static_cast<boost::uint_least16_t>((n*8 + ReturnBits - 1) / ReturnBits);
+        }
+    }
+
+#ifdef BOOST_RANDOM_THREEFRY4X64_HAS_SPAN
+    /**
+     * @brief Fills @p bytes with random bytes, see fill_bytes(void*, std::size_t).
+     */
+    void fill_bytes(std::span<std::byte> bytes)
+    { fill_bytes(bytes.data(), bytes.size()); }
+#endif
+
+    /**
+     * @brief Writes the next @p nblocks encrypted 256 bit blocks to @p out.
+     *
+     * Each block is stored as 4 consecutive 64 bit words. The blocks start
+     * at the first block boundary at or after the current position, the
+     * unused values of a partially consumed block are skipped. Afterwards
+     * the engine is positioned at the end of the last block written, i.e.
+     * the call is equivalent to discarding the rest of a partially consumed
+     * block followed by @p nblocks * samples_per_block values.
+     *
+     * A single block is encrypted with the unrolled rounds, more blocks
+     * with the bulk kernel and a key schedule computed for this call, see
+     * the overload that takes the schedule to reuse one across calls.
+     *
+     * @param out    destination of 4 * @p nblocks 64 bit words.
+     * @param nblocks the number of blocks to generate.
+     */
+    void generate_blocks(boost::uint_least64_t* out, std::size_t nblocks)
+    {
+        if (nblocks > 1) {
+            boost::uint_least64_t ks[5];
+            key_words(ks);
+            boost::uint_least64_t schedule[Rounds/4 + 1][4];
+            detail::threefry4_expand_key<Rounds>(ks, schedule);
+            encrypt_blocks(schedule, out, nblocks);
+            return;
+        }
+
+        if (block_offset() != 0) {
+            inc_counter();
+            _o_counter = lazy_flag;
+        }
+        if (nblocks == 0) return;
+
+        // the kernels only write through memcpy and SIMD stores, see fill_bytes()
+        boost::uint_least64_t block[4];
+        encrypt_block(_counter, block);
+        std::memcpy(out, block, sizeof(block));
+        _o_counter = samples_per_block;
+    }
+
+    /**
+     * @brief Writes the next @p nblocks encrypted 256 bit blocks to @p out,
+     * using the precomputed key schedule @p schedule.
+     *
+     * Same as generate_blocks(out, nblocks), without expanding the key on
+     * every call. @p schedule must be the key_schedule() of an engine with
+     * the same key, e.g. of the root engine of substreams that are used by
+     * different threads.
+     */
+    void generate_blocks(const key_schedule_type& schedule, boost::uint_least64_t* out, std::size_t nblocks)
+    { encrypt_blocks(schedule._schedule, out, nblocks); }
+
+    /**
+     * @brief Returns the key schedule of the key of the engine, for
+     * generate_blocks(schedule, out, nblocks).
+     *
+     * The schedule encrypts a counter like the engine does, i.e. with the
+     * words of the counter beyond CounterSize zero.
+     */
+    key_schedule_type key_schedule() const
+    {
+        typename key_schedule_type::key_type key = {{0, 0, 0, 0}};
+        for (std::size_t i=0; i<KeySize; ++i)
+            key[i] = _key[i+1];
+        return key_schedule_type(key);
+    }
+    
+    /**
+     * @brief Returns the next encrypted 256 bit block.
+     *
+     * Same as generate_blocks() with a single block: the block starts at the
+     * first block boundary at or after the current position, and the engine
+     * is positioned at its end. The output block of the engine isn't used,
+     * so consumers of whole blocks don't pay for storing it and extracting
+     * the words one at a time.
+     */
+    block_type next_block()
+    {
+        if (block_offset() != 0)
+            inc_counter();
+        block_type block;
+        encrypt_block(_counter, block.elems);
+        _o_counter = samples_per_block;
+        return block;
+    }
+
+    /**
+     * @brief Discard a number of elements from the random numbers sequence.
+     *
+     * @param z the number of elements to discard.
+     */
+    void discard(boost::uintmax_t z)
+    { state::discard(_counter, _o_counter, z); }
+
+    /**
+     * @brief Discard a multi-word number of elements from the random numbers sequence.
+     *
+     * The cost doesn't depend on @p z, the carry is propagated over all
+     * counter words and the position wraps around at the end of the cycle.
+     *
+     * @param z the number of elements to discard.
+     */
+    void discard(const position_type& z)
+    { state::discard(_counter, _o_counter, z); }
+
+    /**
+     * @brief Returns the absolute position of the next value in the sequence.
+     *
+     * The position is the number of values drawn since the counter was zero,
+     * seek(tell()) doesn't change the sequence.
+     */
+    position_type tell() const
+    { return state::tell(_counter, _o_counter); }
+
+    /**
+     * @brief Jumps to the absolute position @p p, keeping the key.
+     *
+     * Jumping is pure counter arithmetic, the block is encrypted by the
+     * first draw.
+     *
+     * @param p the position of the next value, see tell().
+     */
+    void seek(const position_type& p)
+    { state::seek(_counter, _o_counter, p); }
+
+    /**
+     * @brief Returns the index of the stream the engine is in.
+     */
+    boost::uint_least64_t stream() const
+    { return state::stream(_counter, _o_counter); }
+
+    /**
+     * @brief Jumps to the start of stream @p s, keeping the key.
+     *
+     * The counter space of 2^(64*CounterSize) blocks is divided into
+     * 2^stream_bits streams of 2^(64*CounterSize-stream_bits) blocks,
+     * the most significant counter bits are the stream index. Engines
+     * with the same key in different streams produce disjoint parts of
+     * the same sequence as long as neither draws beyond the end of its
+     * stream: 2^64 * 2^(64*(CounterSize-2)) blocks, or 2^32 blocks when
+     * CounterSize is 1.
+     *
+     * Jumping is pure counter arithmetic, the block is encrypted by the
+     * first draw.
+     *
+     * @param s the stream index, must be smaller than 2^stream_bits.
+     */
+    void seek_stream(boost::uint_least64_t s)
+    { state::seek_stream(_counter, _o_counter, s); }
+
+    /**
+     * @brief Returns a copy of the engine that starts at stream @p s.
+     *
+     * Handing every task substream(task_id) of one root engine gives each
+     * task its own non-overlapping stream without any coordination.
+     */
+    threefry4x64_engine substream(boost::uint_least64_t s) const
+    {
+        threefry4x64_engine eng(*this);
+        eng.seek_stream(s);
+        return eng;
     }
 
 #ifndef BOOST_RANDOM_NO_STREAM_OPERATORS
@@ -301,7 +853,7 @@ public:
         for (unsigned short i=0; i<CounterSize; ++i)
             os << eng._counter[i] << ' ';
             
-        os << eng._o_counter;
+        os << eng.block_offset();
        return os;
     }
    
@@ -326,11 +878,76 @@ public:
         is >> eng._o_counter;
         eng.init_key();
         
-        eng.encrypt_counter();
+        // the block gets encrypted by the first draw
+        if (eng._o_counter < samples_per_block)
+            eng._o_counter |= lazy_flag;
         return is;
     } 
 #endif
 
+    /**
+     * @brief The number of bytes written by save() and read by load().
+     */
+    BOOST_STATIC_CONSTANT(std::size_t, state_size = 8*(KeySize + CounterSize + 2));
+
+    /**
+     * @brief The first word of a saved state: the format version and the
+     * template parameters of the engine.
+     */
+    BOOST_STATIC_CONSTANT(boost::uint_least64_t, state_tag =
+        0x5446u                                             // "FT"
+        | (static_cast<boost::uint_least64_t>(1) << 16)     // format version
+        | (static_cast<boost::uint_least64_t>(ReturnBits) << 24)
+        | (static_cast<boost::uint_least64_t>(Rounds & 0xFFFF) << 32)
+        | (static_cast<boost::uint_least64_t>(KeySize) << 48)
+        | (static_cast<boost::uint_least64_t>(CounterSize) << 56));
+
+    /**
+     * @brief Writes the state to the state_size bytes at @p dst.
+     *
+     * The state is state_tag, the key words, the counter words and the offset
+     * in the current block, each as a little endian 64 bit word, so it can be
+     * read back on any platform.
+     */
+    void save(void* dst) const
+    {
+        unsigned char* p = static_cast<unsigned char*>(dst);
+        detail::threefry4x64_store_le(p, state_tag);
+        p += 8;
+        for (std::size_t i=0; i<KeySize; ++i, p+=8)
+            detail::threefry4x64_store_le(p, _key[i+1]);
+        for (std::size_t i=0; i<CounterSize; ++i, p+=8)
+            detail::threefry4x64_store_le(p, _counter[i]);
+        detail::threefry4x64_store_le(p, block_offset());
+    }
+
+    /**
+     * @brief Reads a state written by save() from the state_size bytes at @p src.
+     *
+     * Nothing is encrypted, the block gets encrypted by the first draw.
+     *
+     * @returns false and leaves the engine unchanged if the state was saved
+     *          by an engine of a different type or is invalid.
+     */
+    bool load(const void* src)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(src);
+        if (detail::threefry4x64_load_le(p) != state_tag) return false;
+        if (detail::threefry4x64_load_le(p + state_size - 8) > samples_per_block) return false;
+        p += 8;
+
+        for (std::size_t i=0; i<KeySize; ++i, p+=8)
+            _key[i+1] = detail::threefry4x64_load_le(p);
+        for (std::size_t i=0; i<CounterSize; ++i, p+=8)
+            _counter[i] = detail::threefry4x64_load_le(p);
+        _o_counter = static_cast<boost::uint_least16_t>(detail::threefry4x64_load_le(p));
+        init_key();
+
+        if (_o_counter < samples_per_block)
+            _o_counter |= lazy_flag;
+        return true;
+    }
+
     /**
      * @brief Compares two %threefry4x64_engine
      * objects of the same type for equality.
@@ -345,13 +962,18 @@ public:
     friend bool 
     operator==(const threefry4x64_engine& _lhs, const threefry4x64_engine& _rhs) 
     {
-        if (_lhs._o_counter != _rhs._o_counter) return false;
-        
-        for (unsigned short i=0; i<KeySize; ++i)
+        for (unsigned short i=1; i<=KeySize; ++i)
             if (_lhs._key[i] != _rhs._key[i]) return false;
 
+        // the end of a block is the same position as the start of the next block
+        boost::uint_least64_t lhs_counter[CounterSize];
+        boost::uint_least64_t rhs_counter[CounterSize];
+        std::size_t lhs_offset = _lhs.normalized_position(lhs_counter);
+        std::size_t rhs_offset = _rhs.normalized_position(rhs_counter);
+        if (lhs_offset != rhs_offset) return false;
+
         for (unsigned short i=0; i<CounterSize; ++i)
-            if (_lhs._counter[i] != _rhs._counter[i]) return false;
+            if (lhs_counter[i] != rhs_counter[i]) return false;
 
         return true;
     }
@@ -372,166 +994,163 @@ public:
 
 
 private:
-    inline void rotl64(boost::uint_least64_t& v, const boost::uint8_t bits) const
-    { 
-        v = (v << bits) | (v >> (64 - bits));
-    }
-    
-    inline void mix64(boost::uint_least64_t& x0, boost::uint64_t& x1, const boost::uint8_t bits) const
+    template<class Engine, class T>
+    friend void parallel_generate(Engine& eng, T* first, T* last, unsigned int threads);
+    template<class Engine>
+    friend class engine_view;
+
+    BOOST_STATIC_CONSTANT(std::size_t, bulk_blocks = 16);
+
+    // blocks per chunk when fill_bytes() copies from a buffer, 4KB on the stack
+    BOOST_STATIC_CONSTANT(std::size_t, byte_blocks = 128);
+
+    // the counter and offset arithmetic, shared with counter_based_engine
+    typedef detail::counter_state<boost::uint_least64_t, 64, CounterSize, 256/ReturnBits> state;
+
+    // set in _o_counter when the engine has been positioned in a block that
+    // isn't encrypted yet, the remaining bits are the offset in the block
+    BOOST_STATIC_CONSTANT(boost::uint_least16_t, lazy_flag = state::lazy_flag);
+
+    typedef boost::integral_constant<bool, Layout::output_cache> has_output_cache;
+
+    // the offset in the current block
+    std::size_t block_offset() const
+    { return state::offset(_o_counter); }
+
+    // operator() with the cached output block
+    result_type next(boost::true_type)
     {
-        x0 += x1;
-        rotl64(x1, bits);
-        x1 ^= x0;
+        // can we return a value from the current block?
+        if (_o_counter < samples_per_block)
+            return detail::extract4x64_impl<UIntType,ReturnBits>::nth(this->_output, _o_counter++);
+        
+        // generate a new block and return the first result_type 
+        if (_o_counter == samples_per_block) {
+            inc_counter();
+            encrypt_counter();
+            _o_counter = 1; // the next call
+            return detail::extract4x64_impl<UIntType,ReturnBits>::zth(this->_output);
+        }
+        
+        // the engine was positioned but the block is not encrypted yet
+        _o_counter &= ~lazy_flag;
+        encrypt_counter();
+        return detail::extract4x64_impl<UIntType,ReturnBits>::nth(this->_output, _o_counter++);
     }
 
-    inline void double_mix64(   boost::uint_least64_t& x0, boost::uint_least64_t& x1, const boost::uint8_t rx,
-                                boost::uint_least64_t& z0, boost::uint_least64_t& z1, const boost::uint8_t rz) const
+    // operator() without output block, every value encrypts its block
+    result_type next(boost::false_type)
     {
-        mix64(x0,x1,rx);
-        mix64(z0,z1,rz);
+        if (_o_counter == samples_per_block) {
+            inc_counter();
+            _o_counter = 0;
+        }
+        boost::uint_least64_t buffer[4];
+        current_block(buffer, boost::false_type());
+        return detail::extract4x64_impl<UIntType,ReturnBits>::nth(buffer, _o_counter++);
     }
 
-    template <std::size_t offset>
-    inline void add_key64_t( boost::uint_least64_t (&output)[4], boost::uint_least64_t (&key)[KeySize+1], const std::size_t c) const
+    // the block of the current counter, the cached output block or buffer
+    const boost::uint_least64_t* current_block(boost::uint_least64_t (&buffer)[4])
+    { return current_block(buffer, has_output_cache()); }
+
+    const boost::uint_least64_t* current_block(boost::uint_least64_t (&)[4], boost::true_type)
     {
-        if (((offset+1)%5) <= KeySize) output[0] += key[(offset+1)%5];
-        if (((offset+2)%5) <= KeySize) output[1] += key[(offset+2)%5];
-        if (((offset+3)%5) <= KeySize) output[2] += key[(offset+3)%5];
-        if (((offset+4)%5) <= KeySize) output[3] += key[(offset+4)%5];
-        output[3] += c;
+        // encrypt the current block if that was postponed
+        if (_o_counter & lazy_flag) {
+            _o_counter &= ~lazy_flag;
+            encrypt_counter();
+        }
+        return this->_output;
     }
 
-    template <std::size_t R>
-    inline void encrypt_counter_t(std::size_t& four_cycles)
+    const boost::uint_least64_t* current_block(boost::uint_least64_t (&buffer)[4], boost::false_type)
     {
-        double_mix64( _output[0], _output[1], 14, _output[2], _output[3], 16); if (R<2) return;
-        double_mix64( _output[0], _output[3], 52, _output[2], _output[1], 57); if (R<3) return;
-        double_mix64( _output[0], _output[1], 23, _output[2], _output[3], 40); if (R<4) return;
-        double_mix64( _output[0], _output[3],  5, _output[2], _output[1], 37);
-        add_key64_t<1>(_output, _key, ++four_cycles); if (R<5) return;
-     
-        double_mix64( _output[0], _output[1], 25, _output[2], _output[3], 33); if (R<6) return;
-        double_mix64( _output[0], _output[3], 46, _output[2], _output[1], 12); if (R<7) return;
-        double_mix64( _output[0], _output[1], 58, _output[2], _output[3], 22); if (R<8) return;
-        double_mix64( _output[0], _output[3], 32, _output[2], _output[1], 32);
-        add_key64_t<2>(_output, _key, ++four_cycles); if (R<9) return;
-        
-        double_mix64( _output[0], _output[1], 14, _output[2], _output[3], 16); if (R<10) return;
-        double_mix64( _output[0], _output[3], 52, _output[2], _output[1], 57); if (R<11) return;
-        double_mix64( _output[0], _output[1], 23, _output[2], _output[3], 40); if (R<12) return;
-        double_mix64( _output[0], _output[3],  5, _output[2], _output[1], 37);
-        add_key64_t<3>(_output, _key, ++four_cycles); if (R<13) return;
-
-        double_mix64( _output[0], _output[1], 25, _output[2], _output[3], 33); if (R<14) return;
-        double_mix64( _output[0], _output[3], 46, _output[2], _output[1], 12); if (R<15) return;
-        double_mix64( _output[0], _output[1], 58, _output[2], _output[3], 22); if (R<16) return;
-        double_mix64( _output[0], _output[3], 32, _output[2], _output[1], 32); 
-        add_key64_t<4>(_output, _key, ++four_cycles); if (R<17) return;
-        
-        double_mix64( _output[0], _output[1], 14, _output[2], _output[3], 16); if (R<18) return;
-        double_mix64( _output[0], _output[3], 52, _output[2], _output[1], 57); if (R<19) return;
-        double_mix64( _output[0], _output[1], 23, _output[2], _output[3], 40); if (R<20) return;
-        double_mix64( _output[0], _output[3],  5, _output[2], _output[1], 37);
-        add_key64_t<0>(_output, _key, ++four_cycles); if (R<21) return;
-
-        double_mix64( _output[0], _output[1], 25, _output[2], _output[3], 33); if (R<22) return;
-        double_mix64( _output[0], _output[3], 46, _output[2], _output[1], 12); if (R<23) return;
-        double_mix64( _output[0], _output[1], 58, _output[2], _output[3], 22); if (R<24) return;
-        double_mix64( _output[0], _output[3], 32, _output[2], _output[1], 32);
-        add_key64_t<1>(_output, _key, ++four_cycles); if (R<25) return;
-
-        double_mix64( _output[0], _output[1], 14, _output[2], _output[3], 16); if (R<26) return;
-        double_mix64( _output[0], _output[3], 52, _output[2], _output[1], 57); if (R<27) return;
-        double_mix64( _output[0], _output[1], 23, _output[2], _output[3], 40); if (R<28) return;
-        double_mix64( _output[0], _output[3],  5, _output[2], _output[1], 37); 
-        add_key64_t<2>(_output, _key, ++four_cycles); if (R<29) return;
-
-        double_mix64( _output[0], _output[1], 25, _output[2], _output[3], 33); if (R<30) return;
-        double_mix64( _output[0], _output[3], 46, _output[2], _output[1], 12); if (R<31) return;
-        double_mix64( _output[0], _output[1], 58, _output[2], _output[3], 22); if (R<32) return;
-        double_mix64( _output[0], _output[3], 32, _output[2], _output[1], 32); 
-        add_key64_t<3>(_output, _key, ++four_cycles); if (R<33) return;
-
-        double_mix64( _output[0], _output[1], 14, _output[2], _output[3], 16); if (R<34) return;
-        double_mix64( _output[0], _output[3], 52, _output[2], _output[1], 57); if (R<35) return;
-        double_mix64( _output[0], _output[1], 23, _output[2], _output[3], 40); if (R<36) return;
-
-        double_mix64( _output[0], _output[3],  5, _output[2], _output[1], 37);
-        add_key64_t<4>(_output, _key, ++four_cycles); if (R<37) return;
-
-        double_mix64( _output[0], _output[1], 25, _output[2], _output[3], 33); if (R<38) return;
-        double_mix64( _output[0], _output[3], 46, _output[2], _output[1], 12); if (R<39) return;
-        double_mix64( _output[0], _output[1], 58, _output[2], _output[3], 22); if (R<40) return;
-
-        double_mix64( _output[0], _output[3], 32, _output[2], _output[1], 32);
-        add_key64_t<0>(_output, _key, ++four_cycles);
+        _o_counter &= ~lazy_flag;
+        encrypt_block(_counter, buffer);
+        return buffer;
     }
-    
-    void encrypt_counter()
+
+    // where a block for the current counter is written, the cached output block or buffer
+    boost::uint_least64_t* block_buffer(boost::uint_least64_t (&buffer)[4])
+    { return block_buffer(buffer, has_output_cache()); }
+
+    boost::uint_least64_t* block_buffer(boost::uint_least64_t (&)[4], boost::true_type)
+    { return this->_output; }
+
+    boost::uint_least64_t* block_buffer(boost::uint_least64_t (&buffer)[4], boost::false_type)
+    { return buffer; }
+
+    // the counter and offset of the next sample
+    std::size_t normalized_position(boost::uint_least64_t (&counter)[CounterSize]) const
+    { return state::normalize(_counter, _o_counter, counter); }
+
+    // the n-th 32 bit word of a sequence of 256 bit blocks
+    inline static boost::uint_least32_t word32(const boost::uint_least64_t* blocks, std::size_t n)
+    { return static_cast<boost::uint_least32_t>((blocks[n>>1] >> ((n&1)<<5)) & 0xFFFFFFFF); }
+
+    // encrypt a counter with the engine key, all rounds are unrolled at compile time
+    BOOST_FORCEINLINE void encrypt_block(const boost::uint_least64_t (&counter)[CounterSize], boost::uint_least64_t (&output)[4]) const
     {
         for (std::size_t i=0; i<CounterSize; ++i)
-            _output[i] = _counter[i];
+            output[i] = counter[i];
         
         for (std::size_t i=CounterSize; i<4; ++i)
-            _output[i] = 0;
-        
-        for (std::size_t i=0; i<KeySize; ++i)
-            _output[i] +=_key[(i+1)%5];
+            output[i] = 0;
         
-        std::size_t four_cycles = 0;
-
-        // do chunks of 40 rounds
-        for (std::size_t big_rounds=0; big_rounds < Rounds/40; ++big_rounds)
-            encrypt_counter_t<40>(four_cycles);
-        
-        // the remaining rounds
-        encrypt_counter_t<Rounds - 40*(Rounds/40)>(four_cycles);
+        const detail::threefry4x64_short_key<KeySize> key(_key);
+        key.template inject<0>(output);
+        detail::threefry4_rounds<detail::threefry4x64_scalar_ops, Rounds>::apply(output, key);
     }
-    
-    // increment the counter with 1
-    void inc_counter()
-    {
-        ++_counter[0]; 
-        
-        if (CounterSize > 1) {
-            if (_counter[0] != 0) return; // test for overflow, exit when not
-            ++_counter[1];
 
-            if (CounterSize > 2) {
-                if (_counter[1] != 0) return;
-                ++_counter[2];
+    void encrypt_counter()
+    { encrypt_block(_counter, this->_output); }
 
-                if (CounterSize > 3) {
-                    if (_counter[2] != 0) return;
-                    ++_counter[3];
-                }
-            }
+    // generate_blocks() with the subkeys of the engine key
+    void encrypt_blocks(const boost::uint_least64_t (&schedule)[Rounds/4 + 1][4], boost::uint_least64_t* out, std::size_t nblocks)
+    {
+        if (block_offset() != 0) {
+            inc_counter();
+            _o_counter = lazy_flag;
         }
+        if (nblocks == 0) return;
+
+        while (true) {
+            // the kernel only increments the first counter word
+            std::size_t n = nblocks;
+            if (CounterSize > 1 && ~_counter[0] < n - 1)
+                n = static_cast<std::size_t>(~_counter[0]) + 1;
+            
+            boost::uint_least64_t ctr[4] = {0, 0, 0, 0};
+            for (std::size_t i=0; i<CounterSize; ++i)
+                ctr[i] = _counter[i];
+            detail::threefry4x64_encrypt_blocks<Rounds>(schedule, ctr, out, n);
+            
+            inc_counter(n - 1);
+            out += 4*n;
+            nblocks -= n;
+            if (nblocks == 0) break;
+            inc_counter();
+        }
+        _o_counter = samples_per_block;
     }
     
+    // increment the counter with 1
+    void inc_counter()
+    { state::inc(_counter); }
+    
     // increment the counter with z
     void inc_counter(boost::uintmax_t z)
-    {
-        if (CounterSize == 1) {
-            _counter[0] += z;
-            return;
-        }
-        
-        bool overflow = (z > 0xFFFFFFFFFFFFFFFF - _counter[0]);
-        _counter[0] += z;
-        if (!overflow) return;
-        
-        ++_counter[1];
-        
-        if(CounterSize <= 2) return;
-        if (_counter[1]!=0) return;
-
-        ++_counter[2];
-            
-        if(CounterSize <= 3) return;
-        if (_counter[2]!=0) return;
+    { state::inc(_counter, z); }
 
-        ++_counter[3];
+    // the key words in Threefish order followed by the parity word
+    void key_words(boost::uint_least64_t (&ks)[5]) const
+    {
+        for (std::size_t i=0; i<4; ++i)
+            ks[i] = 0;
+        for (std::size_t i=0; i<KeySize; ++i)
+            ks[i] = _key[i+1];
+        ks[4] = _key[0];
     }
 
     void init_key()
@@ -543,14 +1162,9 @@ private:
         if (KeySize>3)  _key[0] ^= _key[4];
     }
     
+    // counter zero, the block gets encrypted by the first draw
     void reset_counter()
-    {
-        _counter[0] = 0xFFFFFFFFFFFFFFFF;
-        if (CounterSize>=2) _counter[1] = 0xFFFFFFFFFFFFFFFF;
-        if (CounterSize>=3) _counter[2] = 0xFFFFFFFFFFFFFFFF;
-        if (CounterSize>=4) _counter[3] = 0xFFFFFFFFFFFFFFFF;
-        _o_counter  = samples_per_block;
-    }
+    { state::reset(_counter, _o_counter); }
 
     // reset the counter to zero, and reset the key
     void reset_after_key_change()
@@ -560,14 +1174,22 @@ private:
     }
 
     
+    // the output block is in the threefry4x64_output_cache base
     boost::uint_least64_t _counter[CounterSize];    // the 256 bit counter (message) that gets encrypted
-    boost::uint_least64_t _output[4];               // the 256 bit cipher output 4 * 64 bit = 256 bit output
     boost::uint_least64_t _key[KeySize+1];            // the 256 bit encryption key
     boost::uint_least16_t _o_counter;               // output chunk counter, e.g. for a 64 bit random engine
                                                     // the 256 bit output buffer gets split in 4x64bit chunks or 8x32bit chunks chunks.
     /// \endcond
 };
 
+#ifndef BOOST_NO_INCLASS_MEMBER_INITIALIZATION
+//  A definition is required even for integral static constants
+template<typename UIntType, std::size_t ReturnBits, std::size_t Rounds, std::size_t KeySize, std::size_t CounterSize, class Layout>
+const std::size_t threefry4x64_engine<UIntType, ReturnBits, Rounds, KeySize, CounterSize, Layout>::state_size;
+template<typename UIntType, std::size_t ReturnBits, std::size_t Rounds, std::size_t KeySize, std::size_t CounterSize, class Layout>
+const boost::uint_least64_t threefry4x64_engine<UIntType, ReturnBits, Rounds, KeySize, CounterSize, Layout>::state_tag;
+#endif
+
 /**
  * 32 bit version of the 13 rounds threefry engine, 64 bit seed, 2^67 cycle length
  */
@@ -589,6 +1211,34 @@ typedef threefry4x64_engine<boost::uint32_t, 32, 20, 1, 1> threefry4x64_20;
  */
 typedef threefry4x64_engine<boost::uint64_t, 64, 20, 1, 1> threefry4x64_20_64;
 
+/**
+ * @brief Saves the engines [@p first, @p last) to @p dst as consecutive
+ * states of Engine::state_size bytes, see threefry4x64_engine::save().
+ */
+template<class Engine>
+void save_engines(const Engine* first, const Engine* last, void* dst)
+{
+    unsigned char* p = static_cast<unsigned char*>(dst);
+    for (; first != last; ++first, p += Engine::state_size)
+        first->save(p);
+}
+
+/**
+ * @brief Loads the engines [@p first, @p last) from the consecutive states
+ * at @p src written by save_engines(), e.g. from a memory mapped file.
+ *
+ * @returns false if a state could not be loaded. The engines before it are
+ *          loaded, that engine and the ones after it are unchanged.
+ */
+template<class Engine>
+bool load_engines(const void* src, Engine* first, Engine* last)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(src);
+    for (; first != last; ++first, p += Engine::state_size)
+        if (!first->load(p)) return false;
+    return true;
+}
+
 } // namespace random
 
 
@@ -0,0 +1,249 @@
+/* boost random/threefry4x64_array.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_THREEFRY4X64_ARRAY_HPP
+#define BOOST_RANDOM_THREEFRY4X64_ARRAY_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/align/aligned_allocator.hpp>
+#include <boost/random/threefry4x64.hpp>
+#include <boost/random/detail/counter_state.hpp>
+#include <boost/random/detail/threefry4x64_kernel.hpp>
+
+namespace boost {
+namespace random {
+
+/**
+ * @brief An array of independent engines stored as a structure of arrays.
+ *
+ * Only defined for @c threefry4x64_engine.
+ */
+template<class Engine>
+class engine_array;
+
+/**
+ * @brief An array of %threefry4x64_engine streams in structure-of-arrays layout.
+ *
+ * The key words, counter words and output blocks of all streams are kept in
+ * separate 64 byte aligned arrays, word j of stream i at index i of array j,
+ * so that consecutive streams are encrypted together in the SIMD lanes of the
+ * block kernel. Stream i produces exactly the values of the engine it was set
+ * from, draw() advances every stream by one value and draw() with a mask only
+ * the selected ones.
+ */
+template<typename UIntType, std::size_t ReturnBits, std::size_t Rounds, std::size_t KeySize, std::size_t CounterSize, class Layout>
+class engine_array< threefry4x64_engine<UIntType, ReturnBits, Rounds, KeySize, CounterSize, Layout> >
+{
+public:
+    typedef threefry4x64_engine<UIntType, ReturnBits, Rounds, KeySize, CounterSize, Layout> engine_type;
+    typedef UIntType result_type;
+
+    /** the number of streams that are encrypted together, the storage is padded to a multiple of it */
+    BOOST_STATIC_CONSTANT(std::size_t, tile = 8);
+
+    /**
+     * @brief Constructs @p n streams, stream i is substream(i) of the default
+     * constructed engine.
+     */
+    explicit engine_array(std::size_t n = 0)
+    {
+        resize(n);
+        const engine_type eng;
+        for (std::size_t i=0; i<n; ++i)
+            set(i, eng.substream(i));
+    }
+
+    /**
+     * @brief Constructs one stream for every engine in [@p first, @p last).
+     */
+    engine_array(const engine_type* first, const engine_type* last)
+    {
+        resize(static_cast<std::size_t>(last - first));
+        for (std::size_t i=0; first != last; ++first, ++i)
+            set(i, *first);
+    }
+
+    /**
+     * @brief The number of streams.
+     */
+    std::size_t size() const
+    { return _size; }
+
+    /**
+     * @brief Sets stream @p i to the state of @p eng.
+     */
+    void set(std::size_t i, const engine_type& eng)
+    {
+        unsigned char buffer[engine_type::state_size];
+        eng.save(buffer);
+        const unsigned char* p = buffer + 8;
+
+        boost::uint_least64_t parity = detail::threefry4x64_tweak;
+        for (std::size_t j=0; j<4; ++j) {
+            const boost::uint_least64_t k = (j < KeySize) ? detail::threefry4x64_load_le(p + 8*j) : 0;
+            word(key_word + j)[i] = k;
+            parity ^= k;
+        }
+        word(key_word + 4)[i] = parity;
+        p += 8*KeySize;
+
+        for (std::size_t j=0; j<4; ++j)
+            word(ctr_word + j)[i] = (j < CounterSize) ? detail::threefry4x64_load_le(p + 8*j) : 0;
+        p += 8*CounterSize;
+
+        // the block gets encrypted by the first draw
+        const std::size_t o = static_cast<std::size_t>(detail::threefry4x64_load_le(p));
+        _offset[i] = static_cast<boost::uint_least16_t>(o < samples_per_block ? (o | lazy_flag) : o);
+    }
+
+    /**
+     * @brief Returns an engine in the state of stream @p i.
+     */
+    engine_type get(std::size_t i) const
+    {
+        unsigned char buffer[engine_type::state_size];
+        unsigned char* p = buffer;
+        detail::threefry4x64_store_le(p, engine_type::state_tag);
+        p += 8;
+        for (std::size_t j=0; j<KeySize; ++j, p+=8)
+            detail::threefry4x64_store_le(p, word(key_word + j)[i]);
+        for (std::size_t j=0; j<CounterSize; ++j, p+=8)
+            detail::threefry4x64_store_le(p, word(ctr_word + j)[i]);
+        detail::threefry4x64_store_le(p, state::offset(_offset[i]));
+
+        engine_type eng;
+        eng.load(buffer);
+        return eng;
+    }
+
+    /**
+     * @brief Draws the next value of every stream, stream i writes to @p out[i].
+     */
+    void draw(result_type* out)
+    { draw_impl(out, all_streams()); }
+
+    /**
+     * @brief Draws the next value of the streams i for which @p mask[i] is
+     * true into @p out[i], the other streams and elements of @p out are
+     * left unchanged.
+     */
+    template<class Mask>
+    void draw(result_type* out, const Mask& mask)
+    { draw_impl(out, mask); }
+
+private:
+    /// \cond show_private
+
+    BOOST_STATIC_CONSTANT(std::size_t, samples_per_block = engine_type::samples_per_block);
+
+    // the offsets have the bit layout of the engine, see set() and get()
+    typedef detail::counter_state<boost::uint_least64_t, 64, CounterSize, samples_per_block> state;
+    BOOST_STATIC_CONSTANT(boost::uint_least16_t, lazy_flag = state::lazy_flag);
+
+    // the arrays: 4 key words and the parity word, 4 counter words, 4 output words
+    BOOST_STATIC_CONSTANT(std::size_t, key_word = 0);
+    BOOST_STATIC_CONSTANT(std::size_t, ctr_word = 5);
+    BOOST_STATIC_CONSTANT(std::size_t, out_word = 9);
+    BOOST_STATIC_CONSTANT(std::size_t, words = 13);
+
+    struct all_streams
+    {
+        bool operator[](std::size_t) const { return true; }
+    };
+
+    void resize(std::size_t n)
+    {
+        _size = n;
+        _capacity = (n + tile - 1) / tile * tile;
+        _words.assign(words * _capacity, 0);
+        _offset.assign(_capacity, static_cast<boost::uint_least16_t>(lazy_flag));
+    }
+
+    boost::uint_least64_t* word(std::size_t j)
+    { return _words.data() + j*_capacity; }
+
+    const boost::uint_least64_t* word(std::size_t j) const
+    { return _words.data() + j*_capacity; }
+
+    template<class Mask>
+    void draw_impl(result_type* out, const Mask& mask)
+    {
+        if (_size == 0) return;
+        const boost::uint_least64_t* block = word(out_word);
+        for (std::size_t t=0; t<_size; t+=tile) {
+            const std::size_t end = (std::min)(t + tile, _size);
+
+            bool refill = false;
+            for (std::size_t i=t; i<end; ++i)
+                if (mask[i] && _offset[i] >= samples_per_block)
+                    refill = true;
+
+            // a new block for some of the streams: position all streams of the tile at
+            // the start of a block and encrypt them together, re-encrypting an unchanged
+            // counter gives the same block
+            if (refill) {
+                for (std::size_t i=t; i<end; ++i) {
+                    if (_offset[i] == samples_per_block) {
+                        inc_counter(i);
+                        _offset[i] = 0;
+                    }
+                    else {
+                        _offset[i] &= ~lazy_flag;
+                    }
+                }
+                encrypt_tile(t);
+            }
+
+            for (std::size_t i=t; i<end; ++i)
+                if (mask[i])
+                    out[i] = extract(block, i, _offset[i]++);
+        }
+    }
+
+    // the n-th value of the output block of stream i
+    result_type extract(const boost::uint_least64_t* block, std::size_t i, std::size_t n) const
+    {
+        const std::size_t bit = n * ReturnBits;
+        return static_cast<result_type>((block[(bit/64)*_capacity + i] >> (bit%64)) & (engine_type::max)());
+    }
+
+    void inc_counter(std::size_t i)
+    {
+        for (std::size_t j=0; j<CounterSize; ++j)
+            if (++word(ctr_word + j)[i] != 0) break;
+    }
+
+    void encrypt_tile(std::size_t t)
+    {
+        const boost::uint_least64_t* const key[5] = { word(key_word), word(key_word+1), word(key_word+2), word(key_word+3), word(key_word+4) };
+        const boost::uint_least64_t* const ctr[4] = { word(ctr_word), word(ctr_word+1), word(ctr_word+2), word(ctr_word+3) };
+        boost::uint_least64_t* const out[4] = { word(out_word), word(out_word+1), word(out_word+2), word(out_word+3) };
+        detail::threefry4x64_encrypt_streams<Rounds>(key, ctr, out, t, tile);
+    }
+
+    std::size_t _size;
+    std::size_t _capacity;
+    std::vector<boost::uint_least64_t, boost::alignment::aligned_allocator<boost::uint_least64_t, 64> > _words;
+    std::vector<boost::uint_least16_t> _offset;
+
+    /// \endcond
+};
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_THREEFRY4X64_ARRAY_HPP
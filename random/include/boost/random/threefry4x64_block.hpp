@@ -0,0 +1,170 @@
+/* boost random/threefry4x64_block.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_THREEFRY4X64_BLOCK_HPP
+#define BOOST_RANDOM_THREEFRY4X64_BLOCK_HPP
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/random/threefry4x64.hpp>
+
+namespace boost {
+namespace random {
+
+/**
+ * @brief An engine that returns whole 256 bit blocks.
+ *
+ * Only defined for @c threefry4x64_engine.
+ */
+template<class Engine>
+class block_engine;
+
+/**
+ * @brief A %threefry4x64_engine that returns a whole 256 bit block per call.
+ *
+ * The result_type is the block_type of the engine, 4 64 bit words. Every
+ * call returns the next block of the underlying engine, as next_block()
+ * does, without the output block and offset bookkeeping of operator().
+ * The underlying engine is always at a block boundary, so the adapter can
+ * be turned back into the engine with engine() and continue value by value.
+ */
+template<typename UIntType, std::size_t ReturnBits, std::size_t Rounds, std::size_t KeySize, std::size_t CounterSize, class Layout>
+class block_engine< threefry4x64_engine<UIntType, ReturnBits, Rounds, KeySize, CounterSize, Layout> >
+{
+public:
+    typedef threefry4x64_engine<UIntType, ReturnBits, Rounds, KeySize, CounterSize, Layout> engine_type;
+    typedef typename engine_type::block_type result_type;
+    BOOST_STATIC_CONSTANT(std::size_t, word_size = 256);
+    BOOST_STATIC_CONSTANT(std::size_t, rounds = Rounds);
+
+    /**
+     * @brief Constructs a %block_engine with the default seed.
+     */
+    block_engine()
+    {}
+
+    /**
+     * @brief Constructs a %block_engine seeded with @p value.
+     */
+    explicit block_engine(UIntType value)
+    : _engine(value)
+    {}
+
+    /**
+     * @brief Constructs a %block_engine that continues at the first block
+     * boundary at or after the position of @p eng.
+     */
+    explicit block_engine(const engine_type& eng)
+    : _engine(eng)
+    { align(); }
+
+    /**
+     * @brief Re-seeds the underlying engine with @p value.
+     */
+    void seed(UIntType value)
+    { _engine.seed(value); }
+
+    /**
+     * @brief Returns the next block.
+     */
+    result_type operator()()
+    { return _engine.next_block(); }
+
+    /**
+     * @brief Fills [@p first, @p last) with the next blocks, encrypted
+     * together with the bulk kernel.
+     */
+    void generate(result_type* first, result_type* last)
+    {
+        BOOST_STATIC_ASSERT( sizeof(result_type) == 4*sizeof(boost::uint_least64_t) );
+        if (first == last) return;
+        _engine.generate_blocks(first->data(), static_cast<std::size_t>(last - first));
+    }
+
+    /**
+     * @brief Discards @p z blocks.
+     */
+    void discard(boost::uintmax_t z)
+    {
+        // z * samples_per_block values as 2 words, samples_per_block is a power of 2
+        const boost::uint_least64_t spb = engine_type::samples_per_block;
+        typename engine_type::position_type p = typename engine_type::position_type();
+        p[0] = z * spb;
+        p[1] = z / (0xFFFFFFFFFFFFFFFF / spb + 1);
+        _engine.discard(p);
+    }
+
+    /**
+     * @brief The underlying engine, positioned at the start of the next block.
+     */
+    const engine_type& engine() const
+    { return _engine; }
+
+#ifndef BOOST_RANDOM_NO_STREAM_OPERATORS
+    /**
+     * @brief Writes the state of the underlying engine to @p os.
+     */
+    template<class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>&
+    operator<<(std::basic_ostream<CharT, Traits>& os, const block_engine& eng)
+    { return os << eng._engine; }
+
+    /**
+     * @brief Reads the state of the underlying engine from @p is.
+     */
+    template<class CharT, class Traits>
+    friend std::basic_istream<CharT, Traits>&
+    operator>>(std::basic_istream<CharT, Traits>& is, block_engine& eng)
+    {
+        is >> eng._engine;
+        eng.align();
+        return is;
+    }
+#endif
+
+    /**
+     * @brief Returns true if both adapters will return the same blocks.
+     */
+    friend bool operator==(const block_engine& lhs, const block_engine& rhs)
+    { return lhs._engine == rhs._engine; }
+
+    /**
+     * @brief Returns true if the adapters will return different blocks.
+     */
+    friend bool operator!=(const block_engine& lhs, const block_engine& rhs)
+    { return !(lhs == rhs); }
+
+private:
+    /// \cond show_private
+
+    // move the engine to the next block boundary, the adapter keeps it at one
+    void align()
+    {
+        const std::size_t offset = static_cast<std::size_t>(_engine.tell()[0] % engine_type::samples_per_block);
+        if (offset != 0)
+            _engine.discard(engine_type::samples_per_block - offset);
+    }
+
+    engine_type _engine;
+
+    /// \endcond
+};
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_THREEFRY4X64_BLOCK_HPP
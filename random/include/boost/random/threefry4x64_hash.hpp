@@ -0,0 +1,164 @@
+/* boost random/threefry4x64_hash.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_THREEFRY4X64_HASH_HPP
+#define BOOST_RANDOM_THREEFRY4X64_HASH_HPP
+
+#include <cstddef>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+#include <boost/config.hpp>
+#include <boost/random/threefry4x64.hpp>
+#include <boost/random/threefry4x64_uniform.hpp>
+#include <boost/random/threefry4x64_normal.hpp>
+
+namespace boost {
+namespace random {
+
+/**
+ * @brief Random values as a pure function of up to four 64 bit integers.
+ *
+ * A keyed hash that maps a tuple (a, b, c, d), e.g. (entity, step, slot), to
+ * the 256 bit block threefry4x64<Rounds>::encrypt(key, {a, b, c, d}), without
+ * any per-tuple state. Different tuples give independent blocks, and the same
+ * tuple always gives the same block. The block of (a, b, c, d) with the key
+ * {seed, 0, 0, 0} is the block that a threefry4x64_engine with Rounds rounds,
+ * seeded with @p seed, produces for counter (a, b, c, d).
+ *
+ * uniform_01() and normal() use the first word of the block, the batched
+ * versions encrypt the tuples several at a time in SIMD lanes.
+ *
+ * parameter @p Rounds the number of encryption rounds. Must be 1 or higher.
+ */
+template <std::size_t Rounds = 20>
+class threefry4x64_hash
+{
+public:
+    typedef typename threefry4x64<Rounds>::key_type key_type;
+    typedef typename threefry4x64<Rounds>::ctr_type ctr_type;
+    typedef ctr_type result_type;
+    BOOST_STATIC_CONSTANT(std::size_t, rounds = Rounds);
+
+    /**
+     * @brief Constructs the hash with the key {@p seed, 0, 0, 0}.
+     */
+    explicit threefry4x64_hash(boost::uint_least64_t seed = 0)
+    : _schedule(make_key(seed))
+    {}
+
+    /**
+     * @brief Constructs the hash with the key @p key.
+     */
+    explicit threefry4x64_hash(const key_type& key)
+    : _schedule(key)
+    {}
+
+    /**
+     * @brief The block of the tuple (@p a, @p b, @p c, @p d).
+     */
+    ctr_type operator()(boost::uint_least64_t a, boost::uint_least64_t b = 0,
+                        boost::uint_least64_t c = 0, boost::uint_least64_t d = 0) const
+    {
+        const ctr_type ctr = {{ a, b, c, d }};
+        return _schedule.encrypt(ctr);
+    }
+
+    /**
+     * @brief The blocks of the tuples [@p first, @p last), written to @p out.
+     */
+    void operator()(const ctr_type* first, const ctr_type* last, ctr_type* out) const
+    { _schedule.encrypt(first, last, out); }
+
+    /**
+     * @brief A uniform value in [0,1) for the tuple (@p a, @p b, @p c, @p d).
+     */
+    double uniform_01(boost::uint_least64_t a, boost::uint_least64_t b = 0,
+                      boost::uint_least64_t c = 0, boost::uint_least64_t d = 0) const
+    {
+        const ctr_type block = (*this)(a, b, c, d);
+        return detail::threefry4x64_uniform<double>::closed_open(block.data(), 0);
+    }
+
+    /**
+     * @brief The uniform values in [0,1) of the tuples [@p first, @p last), written to @p out.
+     */
+    void uniform_01(const ctr_type* first, const ctr_type* last, double* out) const
+    {
+        ctr_type blocks[bulk_blocks];
+        while (first != last) {
+            const std::size_t n = (std::min)(static_cast<std::size_t>(last - first), static_cast<std::size_t>(bulk_blocks));
+            _schedule.encrypt(first, first + n, blocks);
+            for (std::size_t i=0; i<n; ++i)
+                *out++ = detail::threefry4x64_uniform<double>::closed_open(blocks[i].data(), 0);
+            first += n;
+        }
+    }
+
+    /**
+     * @brief A standard normal value for the tuple (@p a, @p b, @p c, @p d).
+     *
+     * Uses the ziggurat of generate_normal() on the first word of the block.
+     */
+    double normal(boost::uint_least64_t a, boost::uint_least64_t b = 0,
+                  boost::uint_least64_t c = 0, boost::uint_least64_t d = 0) const
+    {
+        const ctr_type block = (*this)(a, b, c, d);
+        return detail::threefry4x64_normal_value<Rounds>(block.data(), 0);
+    }
+
+    /**
+     * @brief The standard normal values of the tuples [@p first, @p last), written to @p out.
+     */
+    void normal(const ctr_type* first, const ctr_type* last, double* out) const
+    {
+        const double * const table_x = detail::normal_table<double>::table_x;
+        ctr_type blocks[bulk_blocks];
+        while (first != last) {
+            const std::size_t n = (std::min)(static_cast<std::size_t>(last - first), static_cast<std::size_t>(bulk_blocks));
+            _schedule.encrypt(first, first + n, blocks);
+
+            // the fast path for all values, without branches
+            bool outside[bulk_blocks];
+            for (std::size_t i=0; i<n; ++i) {
+                const boost::uint_least64_t w = blocks[i][0];
+                const std::size_t layer = static_cast<std::size_t>((w & 0xFF) >> 1);
+                const double x = detail::threefry4x64_ziggurat<double>::fraction(w) * table_x[layer];
+                outside[i] = !(x < table_x[layer+1]);
+                out[i] = (w & 1) ? -x : x;
+            }
+
+            // the few values outside the rectangles
+            for (std::size_t i=0; i<n; ++i)
+                if (outside[i])
+                    out[i] = detail::threefry4x64_normal_value<Rounds>(blocks[i].data(), 0);
+            first += n;
+            out += n;
+        }
+    }
+
+private:
+    BOOST_STATIC_CONSTANT(std::size_t, bulk_blocks = 64);
+
+    static key_type make_key(boost::uint_least64_t seed)
+    {
+        const key_type key = {{ seed, 0, 0, 0 }};
+        return key;
+    }
+
+    threefry4x64_key_schedule<Rounds> _schedule;
+};
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_THREEFRY4X64_HASH_HPP
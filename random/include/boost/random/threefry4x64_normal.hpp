@@ -0,0 +1,220 @@
+/* boost random/threefry4x64_normal.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_THREEFRY4X64_NORMAL_HPP
+#define BOOST_RANDOM_THREEFRY4X64_NORMAL_HPP
+
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+#include <boost/config.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/threefry4x64.hpp>
+#include <boost/random/threefry4x64_uniform.hpp>
+
+namespace boost {
+namespace random {
+
+namespace detail {
+
+    // The bits of a ziggurat draw: bit 0 is the sign, bits 1-7 the layer and
+    // the most significant bits the position in the layer.
+    template<class RealType>
+    struct threefry4x64_ziggurat;
+
+    template<>
+    struct threefry4x64_ziggurat<double>
+    {
+        static inline boost::uint_least64_t word(const boost::uint_least64_t* blocks, std::size_t i)
+        { return blocks[i]; }
+
+        static inline double fraction(boost::uint_least64_t w)
+        { return static_cast<double>(static_cast<boost::int64_t>(w >> 11)) * (1.0 / 9007199254740992.0); }
+    };
+
+    template<>
+    struct threefry4x64_ziggurat<float>
+    {
+        static inline boost::uint_least32_t word(const boost::uint_least64_t* blocks, std::size_t i)
+        { return threefry4x64_uniform<float>::word(blocks, i); }
+
+        static inline float fraction(boost::uint_least32_t w)
+        { return static_cast<float>(static_cast<boost::int32_t>(w >> 8)) * (1.0f / 16777216.0f); }
+    };
+
+    // Uniform bits for the rare draws that leave the fast path. They are
+    // keyed by the block the draw came from and counted by the index of the
+    // value in that block, so they don't depend on any other value, and they
+    // are encrypted with the Rounds of the engine or hash the block came from.
+    template<std::size_t Rounds>
+    class threefry4x64_ziggurat_fallback
+    {
+    public:
+        threefry4x64_ziggurat_fallback(const boost::uint_least64_t* block, std::size_t index)
+        : _n(4)
+        {
+            for (std::size_t i=0; i<4; ++i) {
+                _key[i] = block[i];
+                _ctr[i] = 0;
+            }
+            _ctr[0] = index;
+        }
+
+        boost::uint_least64_t operator()()
+        {
+            if (_n == 4) {
+                _output = threefry4x64<Rounds>::encrypt(_key, _ctr);
+                ++_ctr[1];
+                _n = 0;
+            }
+            return _output[_n++];
+        }
+
+        // [0,1)
+        double closed_open()
+        { return threefry4x64_ziggurat<double>::fraction((*this)()); }
+
+        // (0,1)
+        double open_open()
+        { return (static_cast<double>(static_cast<boost::int64_t>((*this)() >> 12)) + 0.5) * (1.0 / 4503599627370496.0); }
+
+    private:
+        typename threefry4x64<Rounds>::key_type _key;
+        typename threefry4x64<Rounds>::ctr_type _ctr;
+        typename threefry4x64<Rounds>::ctr_type _output;
+        std::size_t _n;
+    };
+
+    // The slow path of the ziggurat of unit_normal_distribution, for the
+    // draw x in layer i (with its sign) that failed the fast test.
+    template<class Fallback>
+    inline double threefry4x64_ziggurat_slow(Fallback& fallback, double x, int i)
+    {
+        const double * const table_x = normal_table<double>::table_x;
+        const double * const table_y = normal_table<double>::table_y;
+        for(;;) {
+            const double sign = x < 0 ? -1.0 : 1.0;
+            x = x * sign;
+            if (i == 0) {
+                // the tail beyond table_x[1]
+                const double tail_start = table_x[1];
+                for(;;) {
+                    double tx = -std::log(fallback.open_open()) / tail_start;
+                    double ty = -std::log(fallback.open_open());
+                    if (2*ty > tx*tx) return (tx + tail_start) * sign;
+                }
+            }
+
+            // the wedge of layer i
+            double y = table_y[i] + fallback.closed_open() * (table_y[i+1] - table_y[i]);
+            if (y < std::exp(-x*x/2)) return x * sign;
+
+            // rejected: a completely new draw
+            boost::uint_least64_t w = fallback();
+            i = static_cast<int>((w & 0xFF) >> 1);
+            x = threefry4x64_ziggurat<double>::fraction(w) * table_x[i];
+            if (w & 1) x = -x;
+            if (std::abs(x) < table_x[i+1]) return x;
+        }
+    }
+
+    // the standard normal value of 64 bit word index of a block of Rounds rounds
+    template<std::size_t Rounds>
+    inline double threefry4x64_normal_value(const boost::uint_least64_t* block, std::size_t index)
+    {
+        const double * const table_x = normal_table<double>::table_x;
+        const boost::uint_least64_t w = block[index];
+        const int layer = static_cast<int>((w & 0xFF) >> 1);
+        const double x = threefry4x64_ziggurat<double>::fraction(w) * table_x[layer];
+        const double sign = (w & 1) ? -1.0 : 1.0;
+        if (x < table_x[layer+1]) return sign * x;
+
+        threefry4x64_ziggurat_fallback<Rounds> fallback(block, index);
+        return threefry4x64_ziggurat_slow(fallback, sign * x, layer);
+    }
+
+} // detail
+
+/**
+ * @brief Fills a range with normally distributed random values.
+ *
+ * The values are computed with the ziggurat of normal_distribution straight
+ * from whole encrypted blocks, one 64 bit word per double (4 per block) or
+ * one 32 bit half word per float (8 per block). About 97% of the values only
+ * need their own word; the others continue with bits that are derived from
+ * their block and their index in it, encrypted with the rounds of @p eng.
+ * The n-th value therefore only depends on the key, the starting counter and
+ * n, so splitting a range over threads with discard() gives the same values.
+ * The blocks start at the first block boundary at or after the current
+ * position of @p eng, and the last block is consumed completely.
+ *
+ * @p RealType must be float or double.
+ *
+ * @param eng    the engine providing the blocks.
+ * @param first  start of the destination range.
+ * @param last   end of the destination range.
+ * @param mean   the mean of the distribution.
+ * @param sigma  the standard deviation of the distribution.
+ */
+template<class Engine, class RealType>
+void generate_normal(Engine& eng, RealType* first, RealType* last,
+                     RealType mean = RealType(0), RealType sigma = RealType(1))
+{
+    typedef detail::threefry4x64_ziggurat<RealType> ziggurat;
+    typedef detail::threefry4x64_ziggurat_fallback<Engine::key_schedule_type::rounds> fallback_type;
+    const double * const table_x = detail::normal_table<double>::table_x;
+    const std::size_t per_block = detail::threefry4x64_uniform<RealType>::per_block;
+    const std::size_t bulk_blocks = 64;
+    boost::uint_least64_t buffer[4*bulk_blocks];
+    bool outside[per_block*bulk_blocks];
+
+    std::size_t n = static_cast<std::size_t>(last - first);
+    if (n == 0) return;
+
+    // the key is expanded once for all chunks
+    const typename Engine::key_schedule_type schedule = eng.key_schedule();
+    while (n > 0) {
+        const std::size_t nblocks = (std::min)((n + per_block - 1) / per_block, bulk_blocks);
+        const std::size_t m = (std::min)(n, nblocks * per_block);
+        eng.generate_blocks(schedule, buffer, nblocks);
+
+        // the fast path for all values, without branches
+        for (std::size_t i=0; i<m; ++i) {
+            const std::size_t layer = static_cast<std::size_t>((ziggurat::word(buffer, i) & 0xFF) >> 1);
+            const RealType x = ziggurat::fraction(ziggurat::word(buffer, i)) * RealType(table_x[layer]);
+            const RealType sign = RealType(1 - 2*static_cast<int>(ziggurat::word(buffer, i) & 1));
+            outside[i] = !(x < RealType(table_x[layer+1]));
+            first[i] = mean + sigma * (sign * x);
+        }
+
+        // the few values outside the rectangles
+        for (std::size_t i=0; i<m; ++i) {
+            if (outside[i]) {
+                const std::size_t layer = static_cast<std::size_t>((ziggurat::word(buffer, i) & 0xFF) >> 1);
+                const RealType x = ziggurat::fraction(ziggurat::word(buffer, i)) * RealType(table_x[layer]);
+                const RealType sign = RealType(1 - 2*static_cast<int>(ziggurat::word(buffer, i) & 1));
+                fallback_type fallback(buffer + 4*(i/per_block), i%per_block);
+                first[i] = mean + sigma * static_cast<RealType>(detail::threefry4x64_ziggurat_slow(fallback, sign * x, static_cast<int>(layer)));
+            }
+        }
+
+        first += m;
+        n -= m;
+    }
+}
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_THREEFRY4X64_NORMAL_HPP
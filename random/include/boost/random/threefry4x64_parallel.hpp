@@ -0,0 +1,143 @@
+/* boost random/threefry4x64_parallel.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_THREEFRY4X64_PARALLEL_HPP
+#define BOOST_RANDOM_THREEFRY4X64_PARALLEL_HPP
+
+#include <cstddef>
+#include <algorithm>
+
+#include <boost/config.hpp>
+#include <boost/random/threefry4x64.hpp>
+
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+#include <system_error>
+#include <thread>
+#include <vector>
+#endif
+
+namespace boost {
+namespace random {
+
+namespace detail {
+
+    // the minimum number of blocks worth starting a thread for
+    static const std::size_t threefry4x64_parallel_min_blocks = 1024;
+
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+    // joins its threads at the latest when it goes out of scope, so that an
+    // exception never destroys a joinable std::thread
+    struct threefry4x64_joiner
+    {
+        ~threefry4x64_joiner()
+        { join(); }
+
+        void join()
+        {
+            for (std::size_t i=0; i<threads.size(); ++i)
+                if (threads[i].joinable())
+                    threads[i].join();
+        }
+
+        std::vector<std::thread> threads;
+    };
+#endif
+
+} // detail
+
+/**
+ * @brief Fills a contiguous range with random values using @p threads threads.
+ *
+ * The output and the final state of @p eng are identical to
+ * eng.generate(first, last), independent of the number of threads. The
+ * full blocks in the range are divided in contiguous chunks, and every
+ * thread positions a copy of the engine at the start of its chunk with the
+ * O(1) discard() and encrypts the counters of that chunk.
+ *
+ * Without C++11 thread support the range is filled by the calling thread.
+ *
+ * @param eng     the engine, advanced as if eng.generate(first, last) was called.
+ * @param first   start of the destination range.
+ * @param last    end of the destination range.
+ * @param threads the number of threads to use, including the calling thread.
+ */
+template<class Engine, class T>
+void parallel_generate(Engine& eng, T* first, T* last, unsigned int threads)
+{
+    const std::size_t words_per_block = 8;
+    const std::size_t n = static_cast<std::size_t>(last - first);
+
+    // a stream that doesn't start at a 32 bit boundary has no block aligned words
+    if (threads <= 1 || (eng.block_offset() * Engine::word_size) % 32 != 0) {
+        eng.generate(first, last);
+        return;
+    }
+
+    // head: the unused words of the current block
+    std::size_t head = (std::min)(n, words_per_block - (eng.block_offset() * Engine::word_size) / 32);
+    eng.generate(first, first + head);
+    first += head;
+
+    // body: full blocks, divided over the threads
+    const std::size_t nblocks = (n - head) / words_per_block;
+    std::size_t nthreads = (std::min)(static_cast<std::size_t>(threads), nblocks / detail::threefry4x64_parallel_min_blocks);
+    if (nthreads > 1) {
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+        // chunk i, positioned with discard() on a copy of the engine
+        const auto fill_chunk = [&eng, first, nblocks, nthreads](std::size_t i) {
+            const std::size_t b0 = nblocks * i / nthreads;
+            const std::size_t b1 = nblocks * (i+1) / nthreads;
+            Engine chunk(eng);
+            chunk.discard(static_cast<boost::uintmax_t>(b0) * Engine::samples_per_block);
+            chunk.generate(first + b0*words_per_block, first + b1*words_per_block);
+        };
+
+        // when a thread can't be started, the calling thread fills the
+        // chunks that have none
+        detail::threefry4x64_joiner workers;
+        workers.threads.reserve(nthreads - 1);
+        std::size_t started = 1;
+        try {
+            for (; started<nthreads; ++started)
+                workers.threads.push_back(std::thread(fill_chunk, started));
+        } catch (const std::system_error&) {
+        }
+
+        fill_chunk(0);
+        for (std::size_t i=started; i<nthreads; ++i)
+            fill_chunk(i);
+        workers.join();
+
+        eng.discard(static_cast<boost::uintmax_t>(nblocks) * Engine::samples_per_block);
+        first += nblocks * words_per_block;
+#endif
+    }
+
+    // tail, and everything when the range is too small to be worth threading
+    eng.generate(first, last);
+}
+
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+/**
+ * @brief Fills a contiguous range with random values using all hardware threads.
+ */
+template<class Engine, class T>
+void parallel_generate(Engine& eng, T* first, T* last)
+{
+    parallel_generate(eng, first, last, (std::max)(1u, std::thread::hardware_concurrency()));
+}
+#endif
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_THREEFRY4X64_PARALLEL_HPP
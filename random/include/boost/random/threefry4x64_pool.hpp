@@ -0,0 +1,264 @@
+/* boost random/threefry4x64_pool.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_THREEFRY4X64_POOL_HPP
+#define BOOST_RANDOM_THREEFRY4X64_POOL_HPP
+
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/align/aligned_alloc.hpp>
+#include <boost/random/threefry4x64.hpp>
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+#include <atomic>
+#include <memory>
+#endif
+
+namespace boost {
+namespace random {
+
+namespace detail {
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+    // the id of the next pool, ids are never reused
+    inline std::atomic<boost::uint_least64_t>& threefry4x64_pool_ids()
+    {
+        static std::atomic<boost::uint_least64_t> ids(1);
+        return ids;
+    }
+#endif
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+    // an engine in a cache line of its own, for the pool with id pool, that
+    // is alive as long as alive hasn't expired
+    template<class Engine>
+    struct BOOST_ALIGNMENT(64) threefry4x64_pool_slot
+    {
+        threefry4x64_pool_slot(boost::uint_least64_t id, const std::weak_ptr<void>& token, const Engine& eng)
+        : engine(eng), pool(id), alive(token)
+        {}
+
+        Engine engine;
+        boost::uint_least64_t pool;
+        std::weak_ptr<void> alive;
+    };
+
+    // the engines of one thread, one per live pool the thread used. The
+    // slots of destroyed pools are freed when the thread next misses the
+    // cache of its last pool, so a thread holds at most one slot per live
+    // pool plus the pools destroyed since then.
+    template<class Engine>
+    class threefry4x64_local_engines : boost::noncopyable
+    {
+    public:
+        threefry4x64_local_engines()
+        : _last(0)
+        {}
+
+        ~threefry4x64_local_engines()
+        {
+            for (std::size_t i=0; i<_slots.size(); ++i)
+                destroy(_slots[i]);
+        }
+
+        Engine* find(boost::uint_least64_t pool)
+        {
+            if (_last != 0 && _last->pool == pool) return &_last->engine;
+
+            _last = 0;
+            std::size_t live = 0;
+            for (std::size_t i=0; i<_slots.size(); ++i) {
+                if (_slots[i]->alive.expired()) {
+                    destroy(_slots[i]);
+                    continue;
+                }
+                if (_slots[i]->pool == pool)
+                    _last = _slots[i];
+                _slots[live++] = _slots[i];
+            }
+            _slots.resize(live);
+            return _last != 0 ? &_last->engine : 0;
+        }
+
+        Engine* insert(boost::uint_least64_t pool, const std::weak_ptr<void>& alive, const Engine& eng)
+        {
+            _slots.reserve(_slots.size() + 1);
+            void* p = boost::alignment::aligned_alloc(64, sizeof(slot));
+            if (p == 0) boost::throw_exception(std::bad_alloc());
+            _last = new (p) slot(pool, alive, eng);
+            _slots.push_back(_last);
+            return &_last->engine;
+        }
+
+        std::size_t size() const
+        { return _slots.size(); }
+
+    private:
+        typedef threefry4x64_pool_slot<Engine> slot;
+
+        static void destroy(slot* s)
+        {
+            s->~slot();
+            boost::alignment::aligned_free(s);
+        }
+
+        std::vector<slot*> _slots;
+        slot* _last;
+    };
+#endif
+
+} // detail
+
+/**
+ * @brief Hands out engine streams to threads and tasks.
+ *
+ * @p Engine is a %threefry4x64_engine or a counter_based_engine, any engine
+ * with substream() and stream_bits.
+ *
+ * Every engine the pool hands out is a substream() of the root engine:
+ * the root key at the start of the next unused stream. Engines of one pool
+ * therefore produce disjoint parts of the sequence of the root key, as long
+ * as neither draws beyond the end of its stream, and no seeds have to be
+ * managed. Handing out an engine is a single atomic increment and a copy,
+ * nothing is encrypted until the first draw.
+ *
+ * local() gives every thread its own engine of the pool, which it keeps
+ * for the lifetime of the pool. Those engines are allocated in cache
+ * lines of their own, so threads drawing from them don't share cache lines.
+ *
+ * The pool hands out the streams from @p first_stream up to the last stream
+ * of the engine, 2^stream_bits - 1, and then throws: with a 64 bit counter,
+ * e.g. CounterSize 1 or threefry2x32, there are only 2^32 streams, and a
+ * stream beyond the last one would wrap around onto the first ones.
+ *
+ * Without C++11 atomics acquire() isn't thread safe, without C++11
+ * thread_local there is no local().
+ */
+template<class Engine>
+class engine_pool : boost::noncopyable
+{
+public:
+    typedef Engine engine_type;
+
+    /**
+     * @brief A pool that hands out the streams @p first_stream, @p first_stream + 1, ...
+     * of the key of @p root.
+     *
+     * The root engine itself shouldn't be drawn from when its stream is one
+     * of them.
+     */
+    explicit engine_pool(const engine_type& root = engine_type(), boost::uint_least64_t first_stream = 0)
+    : _root(root), _next(first_stream)
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+    , _id(detail::threefry4x64_pool_ids().fetch_add(1))
+#endif
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+    , _alive(std::make_shared<char>())
+#endif
+    {}
+
+    /**
+     * @brief Returns an engine at the start of the next unused stream.
+     *
+     * Lock-free, can be called from any number of threads at once.
+     *
+     * @throws std::out_of_range if all streams up to 2^stream_bits - 1 have been handed out.
+     */
+    engine_type acquire()
+    {
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+        const boost::uint_least64_t s = _next.fetch_add(1, std::memory_order_relaxed);
+#else
+        const boost::uint_least64_t s = _next++;
+#endif
+        if (engine_type::stream_bits < 64 && s > last_stream)
+            boost::throw_exception(std::out_of_range("engine_pool: no streams left"));
+        return _root.substream(s);
+    }
+
+    /**
+     * @brief The stream the next acquired engine will get.
+     */
+    boost::uint_least64_t next_stream() const
+    { return _next; }
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+    /**
+     * @brief The engine of the calling thread, acquired on its first call.
+     *
+     * Every call from the same thread returns the same engine, which only
+     * that thread may use, and only while the pool lives. The engines of
+     * destroyed pools are freed by a later local() call of the thread for
+     * another pool, or when the thread ends. Finding the engine of a pool
+     * other than the one of the previous call is linear in the number of
+     * pools the thread uses.
+     *
+     * @throws std::out_of_range like acquire() on the first call of a thread.
+     */
+    engine_type& local()
+    {
+        detail::threefry4x64_local_engines<engine_type>& engines = local_engines();
+        engine_type* eng = engines.find(_id);
+        if (eng == 0)
+            eng = engines.insert(_id, _alive, acquire());
+        return *eng;
+    }
+
+    /**
+     * @brief The number of engines of the calling thread for pools of this
+     * type, those of destroyed pools that haven't been freed yet included.
+     */
+    static std::size_t local_engines_size()
+    { return local_engines().size(); }
+#endif
+
+private:
+    /// \cond show_private
+
+    // the last stream index of the engine, when it has fewer than 2^64 streams
+    BOOST_STATIC_CONSTANT(boost::uint_least64_t, last_stream =
+        (engine_type::stream_bits < 64 ? (static_cast<boost::uint_least64_t>(1) << (engine_type::stream_bits % 64)) - 1 : 0));
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+    static detail::threefry4x64_local_engines<engine_type>& local_engines()
+    {
+        static thread_local detail::threefry4x64_local_engines<engine_type> engines;
+        return engines;
+    }
+#endif
+
+    const engine_type _root;
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+    std::atomic<boost::uint_least64_t> _next;
+    const boost::uint_least64_t _id;
+#else
+    boost::uint_least64_t _next;
+#endif
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+    // expires when the pool is destroyed, the thread local engines watch it
+    const std::shared_ptr<void> _alive;
+#endif
+
+    /// \endcond
+};
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_THREEFRY4X64_POOL_HPP
@@ -0,0 +1,131 @@
+/* boost random/threefry4x64_uniform.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_THREEFRY4X64_UNIFORM_HPP
+#define BOOST_RANDOM_THREEFRY4X64_UNIFORM_HPP
+
+#include <cstddef>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+#include <boost/config.hpp>
+#include <boost/random/threefry4x64.hpp>
+
+namespace boost {
+namespace random {
+
+namespace detail {
+
+    // conversion of the raw 256 bit blocks to uniform reals
+    template<class RealType>
+    struct threefry4x64_uniform;
+
+    // 4 doubles per block, one per 64 bit word
+    template<>
+    struct threefry4x64_uniform<double>
+    {
+        BOOST_STATIC_CONSTANT(std::size_t, per_block = 4);
+
+        // the 53 most significant bits, [0,1)
+        static inline double closed_open(const boost::uint_least64_t* blocks, std::size_t i)
+        { return static_cast<double>(static_cast<boost::int64_t>(blocks[i] >> 11)) * (1.0 / 9007199254740992.0); }
+
+        // the 52 most significant bits plus a half, (0,1)
+        static inline double open_open(const boost::uint_least64_t* blocks, std::size_t i)
+        { return (static_cast<double>(static_cast<boost::int64_t>(blocks[i] >> 12)) + 0.5) * (1.0 / 4503599627370496.0); }
+    };
+
+    // 8 floats per block, one per 32 bit half word, low half first
+    template<>
+    struct threefry4x64_uniform<float>
+    {
+        BOOST_STATIC_CONSTANT(std::size_t, per_block = 8);
+
+        static inline boost::uint_least32_t word(const boost::uint_least64_t* blocks, std::size_t i)
+        { return static_cast<boost::uint_least32_t>((blocks[i>>1] >> ((i&1)<<5)) & 0xFFFFFFFF); }
+
+        // the 24 most significant bits, [0,1)
+        static inline float closed_open(const boost::uint_least64_t* blocks, std::size_t i)
+        { return static_cast<float>(static_cast<boost::int32_t>(word(blocks, i) >> 8)) * (1.0f / 16777216.0f); }
+
+        // the 23 most significant bits plus a half, (0,1)
+        static inline float open_open(const boost::uint_least64_t* blocks, std::size_t i)
+        { return (static_cast<float>(static_cast<boost::int32_t>(word(blocks, i) >> 9)) + 0.5f) * (1.0f / 8388608.0f); }
+    };
+
+    template<class Engine, class RealType, bool Open>
+    void threefry4x64_generate_uniform(Engine& eng, RealType* first, RealType* last)
+    {
+        typedef threefry4x64_uniform<RealType> uniform;
+        const std::size_t bulk_blocks = 16;
+        boost::uint_least64_t buffer[4*bulk_blocks];
+
+        std::size_t n = static_cast<std::size_t>(last - first);
+        if (n == 0) return;
+
+        // the key is expanded once for all chunks
+        const typename Engine::key_schedule_type schedule = eng.key_schedule();
+        while (n > 0) {
+            const std::size_t nblocks = (std::min)((n + uniform::per_block - 1) / uniform::per_block, bulk_blocks);
+            const std::size_t m = (std::min)(n, nblocks * uniform::per_block);
+            eng.generate_blocks(schedule, buffer, nblocks);
+
+            // branch free loops that compilers can vectorize
+            if (Open) {
+                for (std::size_t i=0; i<m; ++i)
+                    first[i] = uniform::open_open(buffer, i);
+            } else {
+                for (std::size_t i=0; i<m; ++i)
+                    first[i] = uniform::closed_open(buffer, i);
+            }
+            first += m;
+            n -= m;
+        }
+    }
+
+} // detail
+
+/**
+ * @brief Fills a range with uniform random values in [0,1).
+ *
+ * The values are converted straight from whole encrypted blocks: a double
+ * takes the 53 most significant bits of a 64 bit word (4 per block), a float
+ * the 24 most significant bits of a 32 bit half word (8 per block, low half
+ * first). The blocks start at the first block boundary at or after the
+ * current position of @p eng, and the last block is consumed completely,
+ * see threefry4x64_engine::generate_blocks(). The output only depends on the
+ * key and counter of @p eng.
+ *
+ * @p RealType must be float or double.
+ */
+template<class Engine, class RealType>
+void generate_uniform_01(Engine& eng, RealType* first, RealType* last)
+{ detail::threefry4x64_generate_uniform<Engine, RealType, false>(eng, first, last); }
+
+/**
+ * @brief Fills a range with uniform random values in (0,1).
+ *
+ * Like generate_uniform_01(), but 0 is excluded too, for example for taking
+ * logarithms. A double takes the 52 most significant bits of a 64 bit word
+ * plus a half, a float the 23 most significant bits of a 32 bit half word
+ * plus a half.
+ *
+ * @p RealType must be float or double.
+ */
+template<class Engine, class RealType>
+void generate_uniform_01_open(Engine& eng, RealType* first, RealType* last)
+{ detail::threefry4x64_generate_uniform<Engine, RealType, true>(eng, first, last); }
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_THREEFRY4X64_UNIFORM_HPP
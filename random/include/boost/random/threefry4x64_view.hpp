@@ -0,0 +1,254 @@
+/* boost random/threefry4x64_view.hpp header file
+ *
+ * Copyright (c) 2014 M.A. (Thijs) van den Berg
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See http://www.boost.org for most recent version including documentation.
+ *
+ * $Id$
+ */
+
+#ifndef BOOST_RANDOM_THREEFRY4X64_VIEW_HPP
+#define BOOST_RANDOM_THREEFRY4X64_VIEW_HPP
+
+#include <cstddef>
+#include <iterator>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/integer_traits.hpp>
+#include <boost/assert.hpp>
+#include <boost/random/threefry4x64.hpp>
+
+namespace boost {
+namespace random {
+
+/**
+ * @brief An immutable random access range over the values of an engine.
+ *
+ * Only defined for @c threefry4x64_engine.
+ */
+template<class Engine>
+class engine_view;
+
+/**
+ * @brief The values of a %threefry4x64_engine as an immutable random access range.
+ *
+ * Value i of the view is the value the engine would return after discarding
+ * i values from the position it had when the view was constructed. Every
+ * value is a pure function of the key and its position, so view[i] only
+ * encrypts the block that contains value i and a const view can be read
+ * from any number of threads without a shared mutable engine.
+ *
+ * The parallel algorithms of the standard library need forward iterators,
+ * which the iterators of the view are not (see const_iterator), so e.g.
+ * std::transform(std::execution::par, view.begin(), view.end(), out, f)
+ * runs serially with libstdc++. Neither are the iterators of
+ * std::views::iota. Index through a range that has random access iterators
+ * instead, e.g. the destination:
+ *
+ * @code
+ * std::for_each(std::execution::par, out.begin(), out.end(),
+ *               [&](double& x) { x = f(view[&x - out.data()]); });
+ * @endcode
+ *
+ * Iterators keep the last block they encrypted, so walking through the view
+ * encrypts every block once, like successive calls of operator() of the
+ * engine. An iterator is not safe to use from several threads at once, and
+ * must not outlive its view.
+ *
+ * Indices and sizes are 64 bit, so a view holds at most 2^64-1 values. The
+ * rest of the sequence is reached with engine() and seek() on the engine.
+ */
+template<typename UIntType, std::size_t ReturnBits, std::size_t Rounds, std::size_t KeySize, std::size_t CounterSize, class Layout>
+class engine_view< threefry4x64_engine<UIntType, ReturnBits, Rounds, KeySize, CounterSize, Layout> >
+{
+public:
+    typedef threefry4x64_engine<UIntType, ReturnBits, Rounds, KeySize, CounterSize, Layout> engine_type;
+    typedef UIntType result_type;
+    typedef UIntType value_type;
+    typedef boost::uintmax_t size_type;
+    typedef boost::intmax_t difference_type;
+
+    /**
+     * @brief A random access iterator over the view.
+     *
+     * Dereferencing returns the value, not a reference. That makes it a
+     * C++20 random access iterator, but only an input iterator for the
+     * older iterator requirements, which demand a reference for forward
+     * iterators and above. Algorithms that dispatch on iterator_category
+     * therefore treat it as an input iterator, and the parallel algorithms
+     * run serially on it.
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef std::random_access_iterator_tag iterator_concept;
+        typedef UIntType value_type;
+        typedef boost::intmax_t difference_type;
+        typedef UIntType reference;
+        typedef void pointer;
+
+        const_iterator()
+        : _view(0), _i(0), _block(0), _cached(false)
+        {}
+
+        reference operator*() const
+        {
+            const size_type b = _view->block_index(_i);
+            if (!_cached || b != _block) {
+                _view->encrypt(b, _output);
+                _block = b;
+                _cached = true;
+            }
+            return detail::extract4x64_impl<UIntType,ReturnBits>::nth(_output, _view->block_offset(_i));
+        }
+
+        reference operator[](difference_type n) const
+        { return (*_view)[static_cast<size_type>(_i + n)]; }
+
+        const_iterator& operator++() { ++_i; return *this; }
+        const_iterator& operator--() { --_i; return *this; }
+        const_iterator operator++(int) { const_iterator it(*this); ++_i; return it; }
+        const_iterator operator--(int) { const_iterator it(*this); --_i; return it; }
+        const_iterator& operator+=(difference_type n) { _i += static_cast<size_type>(n); return *this; }
+        const_iterator& operator-=(difference_type n) { _i -= static_cast<size_type>(n); return *this; }
+
+        friend const_iterator operator+(const_iterator it, difference_type n) { return it += n; }
+        friend const_iterator operator+(difference_type n, const_iterator it) { return it += n; }
+        friend const_iterator operator-(const_iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const const_iterator& lhs, const const_iterator& rhs)
+        { return static_cast<difference_type>(lhs._i - rhs._i); }
+
+        friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) { return lhs._i == rhs._i; }
+        friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) { return lhs._i != rhs._i; }
+        friend bool operator<(const const_iterator& lhs, const const_iterator& rhs) { return lhs._i < rhs._i; }
+        friend bool operator>(const const_iterator& lhs, const const_iterator& rhs) { return lhs._i > rhs._i; }
+        friend bool operator<=(const const_iterator& lhs, const const_iterator& rhs) { return lhs._i <= rhs._i; }
+        friend bool operator>=(const const_iterator& lhs, const const_iterator& rhs) { return lhs._i >= rhs._i; }
+
+    private:
+        friend class engine_view;
+
+        const_iterator(const engine_view* view, size_type i)
+        : _view(view), _i(i), _block(0), _cached(false)
+        {}
+
+        const engine_view* _view;
+        size_type _i;
+        mutable size_type _block;
+        mutable boost::uint_least64_t _output[4];
+        mutable bool _cached;
+    };
+
+    typedef const_iterator iterator;
+
+    /**
+     * @brief Views the next @p n values of @p eng, the engine itself is not changed.
+     *
+     * By default the view ends 2^64-1 values further, subrange() and seek()
+     * on the engine reach the rest of the sequence.
+     */
+    explicit engine_view(const engine_type& eng, size_type n = boost::integer_traits<size_type>::const_max)
+    : _engine(eng), _size(n)
+    { _offset = eng.normalized_position(_counter); }
+
+    /**
+     * @brief Value @p i of the view, encrypts the block that contains it.
+     */
+    result_type operator[](size_type i) const
+    {
+        boost::uint_least64_t output[4];
+        encrypt(block_index(i), output);
+        return detail::extract4x64_impl<UIntType,ReturnBits>::nth(output, block_offset(i));
+    }
+
+    /**
+     * @brief The view of the values [@p first, @p last) of this view.
+     */
+    engine_view subrange(size_type first, size_type last) const
+    {
+        BOOST_ASSERT( first <= last && last <= _size );
+
+        engine_view view(*this);
+        view._size = last - first;
+        const size_type b = block_index(first);
+        view._offset = block_offset(first);
+        add(view._counter, b);
+        return view;
+    }
+
+    /**
+     * @brief Returns an engine positioned at value @p i of the view.
+     */
+    engine_type engine(size_type i) const
+    {
+        engine_type eng(_engine);
+        for (std::size_t j=0; j<CounterSize; ++j)
+            eng._counter[j] = _counter[j];
+        add(eng._counter, block_index(i));
+        eng._o_counter = static_cast<boost::uint_least16_t>(block_offset(i) | engine_type::lazy_flag);
+        return eng;
+    }
+
+    /** @brief The number of values in the view. */
+    size_type size() const
+    { return _size; }
+
+    /** @brief True if the view has no values. */
+    bool empty() const
+    { return _size == 0; }
+
+    const_iterator begin() const
+    { return const_iterator(this, 0); }
+
+    const_iterator end() const
+    { return const_iterator(this, _size); }
+
+private:
+    /// \cond show_private
+
+    BOOST_STATIC_CONSTANT(std::size_t, samples_per_block = engine_type::samples_per_block);
+
+    // the block of value i, relative to the first block of the view
+    size_type block_index(size_type i) const
+    { return i / samples_per_block + (i % samples_per_block + _offset) / samples_per_block; }
+
+    // the offset of value i in its block
+    std::size_t block_offset(size_type i) const
+    { return static_cast<std::size_t>((i % samples_per_block + _offset) % samples_per_block); }
+
+    // the counter of the first block plus b, carried over all counter words
+    static void add(boost::uint_least64_t (&counter)[CounterSize], size_type b)
+    {
+        counter[0] += b;
+        bool carry = counter[0] < b;
+        for (std::size_t j=1; j<CounterSize && carry; ++j)
+            carry = (++counter[j] == 0);
+    }
+
+    // block b of the view
+    void encrypt(size_type b, boost::uint_least64_t (&output)[4]) const
+    {
+        boost::uint_least64_t counter[CounterSize];
+        for (std::size_t j=0; j<CounterSize; ++j)
+            counter[j] = _counter[j];
+        add(counter, b);
+        _engine.encrypt_block(counter, output);
+    }
+
+    engine_type _engine;
+    boost::uint_least64_t _counter[CounterSize];
+    std::size_t _offset;
+    size_type _size;
+
+    /// \endcond
+};
+
+} // namespace random
+} // namespace boost
+
+#endif // BOOST_RANDOM_THREEFRY4X64_VIEW_HPP
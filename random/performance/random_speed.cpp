@@ -15,6 +15,12 @@
 #include <boost/random.hpp>
 #include <boost/progress.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/random/threefry4x64_uniform.hpp>
+#include <boost/random/threefry4x64_normal.hpp>
+#include <boost/random/threefry4x64_array.hpp>
+#include <boost/random/threefry4x64_hash.hpp>
+#include <boost/random/threefry.hpp>
+#include <boost/random/philox.hpp>
 
 /*
  * Configuration Section
@@ -175,6 +181,198 @@ void timing_sphere(RNG rng, int iter, const std::string & name)
   show_elapsed(t.elapsed(), iter, name);
 }
 
+// stateless threefry block encryption, with the key and with a precomputed key schedule
+template<std::size_t Rounds>
+void timing_threefry4x64(int iter, const std::string & name, boost::random::threefry4x64<Rounds>)
+{
+  typedef boost::random::threefry4x64<Rounds> threefry;
+  typename threefry::key_type key = {{ 1, 2, 3, 4 }};
+  typename threefry::ctr_type ctr = {{ 0, 0, 0, 0 }};
+  const boost::random::threefry4x64_key_schedule<Rounds> schedule(key);
+
+  // make sure we're not optimizing too much
+  volatile boost::uint64_t tmp;
+  boost::timer t;
+  for(int i = 0; i < iter; i++) {
+    ctr[0] = i;
+    tmp = threefry::encrypt(key, ctr)[0];
+  }
+  show_elapsed(t.elapsed(), iter, name + " encrypt");
+
+  t.restart();
+  for(int i = 0; i < iter; i++) {
+    ctr[0] = i;
+    tmp = schedule.encrypt(ctr)[0];
+  }
+  show_elapsed(t.elapsed(), iter, name + " encrypt key schedule");
+}
+
+// encrypt_blocks() with every block kernel that the CPU supports
+template<std::size_t Rounds>
+void timing_threefry4x64_isa(int iter, const std::string & name, boost::random::threefry4x64<Rounds>)
+{
+  typedef boost::random::threefry4x64<Rounds> threefry;
+  typename threefry::key_type key = {{ 1, 2, 3, 4 }};
+  typename threefry::ctr_type ctr = {{ 0, 0, 0, 0 }};
+  const boost::random::threefry4x64_key_schedule<Rounds> schedule(key);
+  const int n = 64;
+  static boost::uint64_t buffer[4*n];
+
+  const boost::random::threefry4x64_isa isas[] = { boost::random::threefry4x64_isa_scalar,
+    boost::random::threefry4x64_isa_sse2, boost::random::threefry4x64_isa_avx2, boost::random::threefry4x64_isa_avx512 };
+  const char* names[] = { " scalar", " sse2", " avx2", " avx512" };
+  for(int k = 0; k < 4; k++) {
+    if(!boost::random::threefry4x64_force_isa(isas[k]))
+      continue;
+    boost::timer t;
+    for(int i = 0; i < iter; i += n) {
+      ctr[0] = i;
+      schedule.encrypt_blocks(ctr, buffer, n);
+    }
+    show_elapsed(t.elapsed(), iter, name + " encrypt_blocks" + names[k]);
+  }
+  boost::random::threefry4x64_force_isa(boost::random::threefry4x64_isa_auto);
+}
+
+// latency of positioning a fresh engine and drawing its first value
+template<class RNG>
+void timing_create_discard(int iter, const std::string & name, RNG)
+{
+  // make sure we're not optimizing too much
+  volatile typename RNG::result_type tmp;
+  boost::timer t;
+  for(int i = 0; i < iter; i++) {
+    RNG rng(static_cast<typename RNG::result_type>(i));
+    rng.discard(1001);
+    rng.discard(i);
+    tmp = rng();
+  }
+  show_elapsed(t.elapsed(), iter, name + " create+discard+draw");
+}
+
+// bulk uniform [0,1) doubles from whole blocks, compared to uniform_01 per value
+template<class RNG>
+void timing_uniform_01(int iter, const std::string & name, RNG rng)
+{
+  const int n = 1024;
+  static double buffer[n];
+  boost::timer t;
+  for(int i = 0; i < iter; i += n)
+    boost::random::generate_uniform_01(rng, buffer, buffer + n);
+  show_elapsed(t.elapsed(), iter, name + " generate_uniform_01<double>");
+
+  boost::random::uniform_01<double> dist;
+  t.restart();
+  for(int i = 0; i < iter; i += n)
+    for(int j = 0; j < n; j++)
+      buffer[j] = dist(rng);
+  show_elapsed(t.elapsed(), iter, name + " uniform_01<double>");
+}
+
+// bulk ziggurat normals from whole blocks, compared to normal_distribution per value
+template<class RNG, class RealType>
+void timing_normal(int iter, const std::string & name, RNG rng, RealType)
+{
+  const int n = 1024;
+  static RealType buffer[n];
+  const std::string type = sizeof(RealType) == sizeof(float) ? "<float>" : "<double>";
+  boost::timer t;
+  for(int i = 0; i < iter; i += n)
+    boost::random::generate_normal(rng, buffer, buffer + n);
+  show_elapsed(t.elapsed(), iter, name + " generate_normal" + type);
+
+  boost::random::normal_distribution<RealType> dist;
+  t.restart();
+  for(int i = 0; i < iter; i += n)
+    for(int j = 0; j < n; j++)
+      buffer[j] = dist(rng);
+  show_elapsed(t.elapsed(), iter, name + " normal_distribution" + type);
+}
+
+// block-wise fill() compared to operator() per value
+template<class RNG>
+void timing_fill(int iter, const std::string & name, RNG rng)
+{
+  const int n = 4096;
+  static typename RNG::result_type buffer[n];
+  boost::timer t;
+  for(int i = 0; i < iter; i += n)
+    rng.fill(buffer, buffer + n);
+  show_elapsed(t.elapsed(), iter, name + " fill");
+
+  t.restart();
+  for(int i = 0; i < iter; i += n)
+    for(int j = 0; j < n; j++)
+      buffer[j] = rng();
+  show_elapsed(t.elapsed(), iter, name + " operator()");
+}
+
+// random bytes with fill_bytes(), reported per byte and in GB/s
+template<class RNG>
+void timing_fill_bytes(int iter, const std::string & name, RNG rng)
+{
+  const int n = 1 << 16;
+  static unsigned char buffer[n];
+  boost::timer t;
+  for(int i = 0; i < iter; i += n)
+    rng.fill_bytes(buffer, n);
+  double elapsed = t.elapsed();
+  show_elapsed(elapsed, iter, name + " fill_bytes");
+  std::cout << name << " fill_bytes: " << iter / elapsed * 1e-9 << " GB/s" << std::endl;
+}
+
+// one value from each of 4096 streams, engine_array compared to separate engines
+template<class RNG>
+void timing_engine_array(int iter, const std::string & name, RNG)
+{
+  const int n = 4096;
+  static typename RNG::result_type buffer[n];
+  std::vector<RNG> engines;
+  for(int i = 0; i < n; i++)
+    engines.push_back(RNG(i));
+  boost::random::engine_array<RNG> streams(&engines[0], &engines[0] + n);
+
+  boost::timer t;
+  for(int i = 0; i < iter; i += n)
+    streams.draw(buffer);
+  show_elapsed(t.elapsed(), iter, name + " engine_array draw");
+
+  t.restart();
+  for(int i = 0; i < iter; i += n)
+    for(int j = 0; j < n; j++)
+      buffer[j] = engines[j]();
+  show_elapsed(t.elapsed(), iter, name + " separate engines");
+}
+
+// stateless normals of (entity, step) tuples, batched compared to one call per tuple
+template<std::size_t Rounds>
+void timing_hash(int iter, const std::string & name, boost::random::threefry4x64<Rounds>)
+{
+  typedef typename boost::random::threefry4x64_hash<Rounds>::ctr_type ctr_type;
+  const int n = 1024;
+  static ctr_type tuples[n];
+  static double buffer[n];
+  const boost::random::threefry4x64_hash<Rounds> hash(42);
+  for(int j = 0; j < n; j++) {
+    const ctr_type c = {{ static_cast<boost::uint64_t>(j), 0, 0, 0 }};
+    tuples[j] = c;
+  }
+
+  boost::timer t;
+  for(int i = 0; i < iter; i += n) {
+    for(int j = 0; j < n; j++)
+      tuples[j][1] = i;
+    hash.normal(tuples, tuples + n, buffer);
+  }
+  show_elapsed(t.elapsed(), iter, name + " hash normal batched");
+
+  t.restart();
+  for(int i = 0; i < iter; i += n)
+    for(int j = 0; j < n; j++)
+      buffer[j] = hash.normal(j, i);
+  show_elapsed(t.elapsed(), iter, name + " hash normal");
+}
+
 template<class RNG>
 void run(int iter, const std::string & name, RNG rng)
 {
@@ -357,6 +555,32 @@ int main(int argc, char*argv[])
   run(iter, "threefry4x64_20", boost::random::threefry4x64_20());
   run(iter, "threefry4x64_13_64", boost::random::threefry4x64_13_64());
   run(iter, "threefry4x64_20_64", boost::random::threefry4x64_20_64());
+  run(iter, "threefry4x64_72_64", boost::random::threefry4x64_engine<boost::uint64_t, 64, 72>());
+  run(iter, "threefry2x64_13_64", boost::random::threefry2x64_13_64());
+  run(iter, "threefry2x64_20_64", boost::random::threefry2x64_20_64());
+  run(iter, "threefry4x32_13", boost::random::threefry4x32_13());
+  run(iter, "threefry4x32_20", boost::random::threefry4x32_20());
+  run(iter, "threefry2x32_13", boost::random::threefry2x32_13());
+  run(iter, "threefry2x32_20", boost::random::threefry2x32_20());
+  run(iter, "philox4x32_10", boost::random::philox4x32_10());
+  run(iter, "philox4x64_10_64", boost::random::philox4x64_10_64());
+  timing_create_discard(iter, "threefry4x64_13", boost::random::threefry4x64_13());
+  timing_create_discard(iter, "threefry4x64_20_64", boost::random::threefry4x64_20_64());
+  timing_fill(iter, "threefry4x64_13_8", boost::random::threefry4x64_engine<boost::uint8_t, 8, 13>());
+  timing_fill(iter, "threefry4x64_13_16", boost::random::threefry4x64_engine<boost::uint16_t, 16, 13>());
+  timing_fill_bytes(iter, "threefry4x64_13_64", boost::random::threefry4x64_13_64());
+  timing_fill_bytes(iter, "threefry4x64_20_64", boost::random::threefry4x64_20_64());
+  timing_engine_array(iter, "threefry4x64_20_64", boost::random::threefry4x64_20_64());
+  timing_uniform_01(iter, "threefry4x64_13_64", boost::random::threefry4x64_13_64());
+  timing_normal(iter, "threefry4x64_13_64", boost::random::threefry4x64_13_64(), 0.0);
+  timing_normal(iter, "threefry4x64_13_64", boost::random::threefry4x64_13_64(), 0.0f);
+  timing_normal(iter, "threefry4x64_20_64", boost::random::threefry4x64_20_64(), 0.0);
+  timing_threefry4x64(iter, "threefry4x64<13>", boost::random::threefry4x64<13>());
+  timing_threefry4x64(iter, "threefry4x64<20>", boost::random::threefry4x64<20>());
+  timing_threefry4x64(iter, "threefry4x64<72>", boost::random::threefry4x64<72>());
+  timing_threefry4x64_isa(iter, "threefry4x64<13>", boost::random::threefry4x64<13>());
+  timing_threefry4x64_isa(iter, "threefry4x64<20>", boost::random::threefry4x64<20>());
+  timing_hash(iter, "threefry4x64<20>", boost::random::threefry4x64<20>());
 
 
   run(iter, "lagged_fibonacci607", boost::lagged_fibonacci607());
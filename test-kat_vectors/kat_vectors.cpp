@@ -27,17 +27,119 @@ These test cases are taken from: https://github.com/girving/random123/blob/maste
 #threefry4x64 72 0000000000000000 0000000000000000 0000000000000000 0000000000000000 0000000000000000 0000000000000000 0000000000000000 0000000000000000 94eeea8b1f2ada84 adf103313eae6670 952419a1f4b16d53 d83f13e63c9f6b11
 #threefry4x64 72 ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff 11518c034bc1ff4c 193f10b8bcdcc9f7 d024229cb58f20d8 563ed6e48e05183f
 #threefry4x64 72 243f6a8885a308d3 13198a2e03707344 a4093822299f31d0 082efa98ec4e6c89 452821e638d01377 be5466cf34e90c6c be5466cf34e90c6c c0ac29b7c97c50dd acf412ccaa3b2270 c9e99bd53f2e9173 43dad469dc825948 fbb19d06c8a2b4dc
+#threefry2x64 13 0000000000000000 0000000000000000 0000000000000000 0000000000000000 f167b032c3b480bd e91f9fee4b7a6fb5
+#threefry2x64 13 ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff ccdec5c917a874b1 4df53abca26ceb01
+#threefry2x64 13 243f6a8885a308d3 13198a2e03707344 a4093822299f31d0 082efa98ec4e6c89 c3aac71561042993 3fe7ae8801aff316
+#threefry2x64 20 0000000000000000 0000000000000000 0000000000000000 0000000000000000 c2b6e3a8c2c69865 6f81ed42f350084d
+#threefry2x64 20 ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff e02cb7c4d95d277a d06633d0893b8b68
+#threefry2x64 20 243f6a8885a308d3 13198a2e03707344 a4093822299f31d0 082efa98ec4e6c89 263c7d30bb0f0af1 56be8361d3311526
+#threefry4x32 13 00000000 00000000 00000000 00000000 00000000 00000000 00000000 00000000 531c7e4f 39491ee5 2c855a92 3d6abf9a
+#threefry4x32 13 ffffffff ffffffff ffffffff ffffffff ffffffff ffffffff ffffffff ffffffff c4189358 1c9cc83a d5881c67 6a0a89e0
+#threefry4x32 13 243f6a88 85a308d3 13198a2e 03707344 a4093822 299f31d0 082efa98 ec4e6c89 4aa71d8f 734738c2 431fc6a8 ae6debf1
+#threefry4x32 20 00000000 00000000 00000000 00000000 00000000 00000000 00000000 00000000 9c6ca96a e17eae66 fc10ecd4 5256a7d8
+#threefry4x32 20 ffffffff ffffffff ffffffff ffffffff ffffffff ffffffff ffffffff ffffffff 2a881696 57012287 f6c7446e a16a6732
+#threefry4x32 20 243f6a88 85a308d3 13198a2e 03707344 a4093822 299f31d0 082efa98 ec4e6c89 59cd1dbb b8879579 86b5d00c ac8b6d84
+#threefry2x32 13 00000000 00000000 00000000 00000000 9d1c5ec6 8bd50731
+#threefry2x32 13 ffffffff ffffffff ffffffff ffffffff fd36d048 2d17272c
+#threefry2x32 13 243f6a88 85a308d3 13198a2e 03707344 ba3e4725 f27d669e
+#threefry2x32 20 00000000 00000000 00000000 00000000 6b200159 99ba4efe
+#threefry2x32 20 ffffffff ffffffff ffffffff ffffffff 1cb996fc bb002be7
+#threefry2x32 20 243f6a88 85a308d3 13198a2e 03707344 c4923a9c 483df7a0
+#philox4x32   10 00000000 00000000 00000000 00000000 00000000 00000000 6627e8d5 e169c58d bc57ac4c 9b00dbd8
+#philox4x32   10 ffffffff ffffffff ffffffff ffffffff ffffffff ffffffff 408f276d 41c83b0e a20bc7c6 6d5451fd
+#philox4x32   10 243f6a88 85a308d3 13198a2e 03707344 a4093822 299f31d0 d16cfe09 94fdcceb 5001e420 24126ea1
+#philox4x64   10 0000000000000000 0000000000000000 0000000000000000 0000000000000000 0000000000000000 0000000000000000 16554d9eca36314c db20fe9d672d0fdc d7e772cee186176b 7e68b68aec7ba23b
+#philox4x64   10 ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff ffffffffffffffff 87b092c3013fe90b 438c3c67be8d0224 9cc7d7c69cd777b6 a09caebf594f0ba0
+#philox4x64   10 243f6a8885a308d3 13198a2e03707344 a4093822299f31d0 082efa98ec4e6c89 452821e638d01377 be5466cf34e90c6c a528f45403e61d95 38c72dbd566e9788 a5a1610e72fd18b5 57bd43b5e52b7fe6
 
 */
 
 #define BOOST_TEST_MODULE threefry
 #include <istream>
 #include <ostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#if defined(__cpp_lib_ranges) && __cpp_lib_ranges >= 201911L
+#include <ranges>
+#endif
 
 #include <boost/test/included/unit_test.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/is_base_of.hpp>
 #include <boost/random/threefry4x64.hpp>
+#include <boost/random/threefry4x64_parallel.hpp>
+#include <boost/random/threefry4x64_pool.hpp>
+#include <boost/random/threefry4x64_array.hpp>
+#include <boost/random/threefry4x64_block.hpp>
+#include <boost/random/threefry4x64_hash.hpp>
+#include <boost/random/threefry4x64_uniform.hpp>
+#include <boost/random/threefry4x64_view.hpp>
+#include <boost/random/threefry4x64_normal.hpp>
+#include <boost/random/threefry.hpp>
+#include <boost/random/philox.hpp>
+
+// The common shape of the bulk tests: run(eng1, expected) gets an engine at
+// value skip and the next n values operator() returns from there, checks its
+// output against them, and has to leave eng1 where operator() left eng2.
+template<class Engine, class Run>
+void check_matches_operator(std::size_t skip, std::size_t n, Run run)
+{
+    Engine eng1(17);
+    Engine eng2(17);
+    eng1.discard(skip);
+    eng2.discard(skip);
+
+    std::vector<typename Engine::result_type> expected(n);
+    for (std::size_t i=0; i<n; ++i)
+        expected[i] = eng2();
+    run(eng1, expected);
+    BOOST_CHECK( eng1 == eng2 );
+    BOOST_CHECK_EQUAL( eng1(), eng2() );
+}
+
+// operator() of Engine that returns recorded values, to get the output of
+// the generic algorithms on a given sequence and the number of values they draw
+template<class Engine>
+struct replay_engine
+{
+    typedef typename Engine::result_type result_type;
+
+    explicit replay_engine(const std::vector<result_type>& values_) : values(values_), drawn(0) {}
+
+    static result_type min BOOST_PREVENT_MACRO_SUBSTITUTION () { return (Engine::min)(); }
+    static result_type max BOOST_PREVENT_MACRO_SUBSTITUTION () { return (Engine::max)(); }
+
+    result_type operator()()
+    {
+        const std::size_t i = drawn++;
+        return i < values.size() ? values[i] : 0;
+    }
+
+    const std::vector<result_type>& values;
+    std::size_t drawn;
+};
 
+// the 32 bit words of generate() for the values v
+template<class Engine>
+std::vector<boost::uint32_t> generate_words(const std::vector<typename Engine::result_type>& v, std::size_t n)
+{
+    replay_engine<Engine> replay(v);
+    std::vector<boost::uint32_t> words(n);
+    boost::random::detail::generate_from_int(replay, words.begin(), words.end());
+    return words;
+}
 
+// the number of values generate() of n words draws
+template<class Engine>
+std::size_t generate_draws(std::size_t n)
+{
+    const std::vector<typename Engine::result_type> none;
+    replay_engine<Engine> replay(none);
+    std::vector<boost::uint32_t> words(n);
+    boost::random::detail::generate_from_int(replay, words.begin(), words.end());
+    return replay.drawn;
+}
 
 BOOST_AUTO_TEST_CASE( threefry4x64_13_8 )
 {
@@ -216,6 +318,256 @@ BOOST_AUTO_TEST_CASE( threefry4x64_20_64_0x45 )
     BOOST_CHECK_EQUAL( eng(), 0x901d406ccebc1ba4 );
 }
 
+template<class Engine>
+void check_threefry4x64_20_0x45_small(const std::size_t bits)
+{
+    Engine eng;
+
+    std::ostringstream os;
+    os << 0x452821e638d01377 << ' ' << 0xbe5466cf34e90c6c << ' ' << 0xbe5466cf34e90c6c << ' ' << 0xc0ac29b7c97c50dd << ' '
+       << 0x243f6a8885a308d3 << ' ' << 0x13198a2e03707344 << ' ' << 0xa4093822299f31d0 << ' ' << 0x082efa98ec4e6c89 << ' ' << 0;
+    std::istringstream is( os.str() );
+    is >> eng;
+
+    // the words of the block in little endian order
+    const boost::uint64_t kat[4] = { 0xa7e8fde591651bd9, 0xbaafd0c30138319b, 0x84a5c1a729e685b9, 0x901d406ccebc1ba4 };
+    const boost::uint64_t mask = (boost::uint64_t(1) << bits) - 1;
+    for (std::size_t j=0; j<4; ++j)
+        for (std::size_t k=0; k<64; k+=bits)
+            BOOST_CHECK_EQUAL( eng(), (kat[j] >> k) & mask );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_20_8_0x45 )
+{
+    check_threefry4x64_20_0x45_small< boost::random::threefry4x64_engine<boost::uint8_t, 8, 20> >(8);
+    check_threefry4x64_20_0x45_small< boost::random::threefry4x64_engine<boost::uint32_t, 8, 20> >(8);
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_20_16_0x45 )
+{
+    check_threefry4x64_20_0x45_small< boost::random::threefry4x64_engine<boost::uint16_t, 16, 20> >(16);
+    check_threefry4x64_20_0x45_small< boost::random::threefry4x64_engine<boost::uint64_t, 16, 20> >(16);
+}
+
+template<class Engine>
+struct fill_values
+{
+    void operator()(Engine& eng, const std::vector<typename Engine::result_type>& expected) const
+    {
+        const std::size_t n = expected.size();
+        std::vector<typename Engine::result_type> v(n+1);
+        eng.fill(&v[0], &v[0] + n);
+        BOOST_CHECK( std::equal(expected.begin(), expected.end(), v.begin()) );
+        BOOST_CHECK_EQUAL( v[n], 0u );
+    }
+};
+
+template<class Engine>
+void check_fill()
+{
+    // fill() gives the operator() sequence for any start and length
+    const std::size_t lengths[] = { 0, 1, 5, Engine::samples_per_block, 3*Engine::samples_per_block + 7, 40*Engine::samples_per_block + 1 };
+    for (std::size_t start=0; start<=Engine::samples_per_block; ++start)
+        for (std::size_t l=0; l<sizeof(lengths)/sizeof(lengths[0]); ++l)
+            check_matches_operator<Engine>(start, lengths[l], fill_values<Engine>());
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_fill )
+{
+    check_fill< boost::random::threefry4x64_engine<boost::uint8_t, 8, 13> >();
+    check_fill< boost::random::threefry4x64_engine<boost::uint32_t, 8, 13> >();
+    check_fill< boost::random::threefry4x64_engine<boost::uint16_t, 16, 20, 4, 2> >();
+    check_fill< boost::random::threefry4x64_13 >();
+    check_fill< boost::random::threefry4x64_20_64 >();
+}
+
+// fill_bytes() of n bytes, align bytes after an 8 byte boundary
+template<class Engine>
+struct fill_bytes_values
+{
+    fill_bytes_values(std::size_t n_, std::size_t align_) : n(n_), align(align_) {}
+
+    void operator()(Engine& eng, const std::vector<typename Engine::result_type>& expected) const
+    {
+        const std::size_t bytes_per_value = Engine::word_size / 8;
+        std::vector<boost::uint64_t> storage(n/8 + 2);
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(&storage[0]) + align;
+        eng.fill_bytes(bytes, n);
+
+        for (std::size_t i=0; i<n; ++i)
+            BOOST_CHECK_EQUAL( bytes[i], (static_cast<boost::uint64_t>(expected[i / bytes_per_value]) >> (8*(i % bytes_per_value))) & 0xff );
+        BOOST_CHECK_EQUAL( bytes[n], 0u );
+    }
+
+    std::size_t n;
+    std::size_t align;
+};
+
+template<class Engine>
+void check_fill_bytes()
+{
+    // the little endian bytes of the operator() values, for any start, length and alignment
+    const std::size_t bytes_per_value = Engine::word_size / 8;
+    const std::size_t lengths[] = { 0, 1, 3, 8, 31, 32, 33, 100, 32*40 + 5 };
+    for (std::size_t start=0; start<=Engine::samples_per_block; ++start) {
+        for (std::size_t l=0; l<sizeof(lengths)/sizeof(lengths[0]); ++l) {
+            for (std::size_t align=0; align<2; ++align) {
+                const std::size_t n = lengths[l];
+                check_matches_operator<Engine>(start, (n + bytes_per_value - 1) / bytes_per_value,
+                    fill_bytes_values<Engine>(n, align));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_fill_bytes )
+{
+    check_fill_bytes< boost::random::threefry4x64_engine<boost::uint8_t, 8, 13> >();
+    check_fill_bytes< boost::random::threefry4x64_engine<boost::uint16_t, 16, 13> >();
+    check_fill_bytes< boost::random::threefry4x64_13 >();
+    check_fill_bytes< boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 4, 2> >();
+
+    // bytes and values mixed, 13 rounds KAT
+    boost::random::threefry4x64_engine<boost::uint32_t, 32, 13> eng;
+    std::istringstream is("0 0 0 0 0 0 0 0 0");
+    is >> eng;
+    unsigned char b[3];
+    BOOST_CHECK_EQUAL( eng(), 0xe1dc8e05 );
+    eng.fill_bytes(b, 3);
+    BOOST_CHECK_EQUAL( b[0], 0xbe );
+    BOOST_CHECK_EQUAL( b[1], 0xfa );
+    BOOST_CHECK_EQUAL( b[2], 0x71 );
+    BOOST_CHECK_EQUAL( eng(), 0x695c9c62 );
+
+#ifdef BOOST_RANDOM_THREEFRY4X64_HAS_SPAN
+    std::byte s[4];
+    eng.fill_bytes(std::span<std::byte>(s));
+    BOOST_CHECK_EQUAL( std::to_integer<int>(s[0]), 0x13 );
+    BOOST_CHECK_EQUAL( std::to_integer<int>(s[3]), 0x02 );
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_binary_state )
+{
+    typedef boost::random::threefry4x64_engine<boost::uint32_t, 32, 20, 2, 2> engine;
+    BOOST_CHECK_EQUAL( engine::state_size, 48u );
+
+    engine eng1(5);
+    eng1.discard(11);
+    unsigned char state[engine::state_size];
+    eng1.save(state);
+
+    // tag, key, counter and offset as little endian words
+    const boost::uint64_t tag = engine::state_tag;
+    BOOST_CHECK_EQUAL( boost::random::detail::threefry4x64_load_le(state), tag );
+    BOOST_CHECK_EQUAL( tag, 0x0202001420015446ULL );
+    BOOST_CHECK_EQUAL( state[8], 5 );
+    BOOST_CHECK_EQUAL( boost::random::detail::threefry4x64_load_le(state + 24), 1u );
+    BOOST_CHECK_EQUAL( boost::random::detail::threefry4x64_load_le(state + 40), 3u );
+
+    engine eng2;
+    BOOST_CHECK( eng2.load(state) );
+    BOOST_CHECK( eng1 == eng2 );
+    for (int i=0; i<20; ++i)
+        BOOST_CHECK_EQUAL( eng1(), eng2() );
+
+    // same state as the text representation
+    std::stringstream ss;
+    ss << eng1;
+    engine eng3;
+    ss >> eng3;
+    eng1.save(state);
+    BOOST_CHECK( eng2.load(state) );
+    BOOST_CHECK( eng2 == eng3 );
+
+    // states of other engine types and invalid offsets are rejected
+    boost::random::threefry4x64_engine<boost::uint32_t, 32, 13, 2, 2> other;
+    BOOST_CHECK( !other.load(state) );
+    state[40] = 9;
+    BOOST_CHECK( !eng2.load(state) );
+    BOOST_CHECK( eng2 == eng3 );
+
+    // bulk save and load
+    std::vector<boost::random::threefry4x64_20_64> engines;
+    for (int i=0; i<10; ++i) {
+        engines.push_back(boost::random::threefry4x64_20_64(i));
+        engines.back().discard(i);
+    }
+    std::vector<unsigned char> buffer(engines.size() * boost::random::threefry4x64_20_64::state_size);
+    boost::random::save_engines(&engines[0], &engines[0] + engines.size(), &buffer[0]);
+    std::vector<boost::random::threefry4x64_20_64> loaded(engines.size());
+    BOOST_CHECK( boost::random::load_engines(&buffer[0], &loaded[0], &loaded[0] + loaded.size()) );
+    for (std::size_t i=0; i<engines.size(); ++i) {
+        BOOST_CHECK( engines[i] == loaded[i] );
+        BOOST_CHECK_EQUAL( engines[i](), loaded[i]() );
+    }
+}
+
+template<class Engine>
+void check_engine_array()
+{
+    // streams at different keys and positions, a size that isn't a multiple of the tile
+    std::vector<Engine> engines;
+    for (int i=0; i<21; ++i) {
+        engines.push_back(Engine(1000 + i));
+        engines.back().discard(i % 5);
+    }
+    boost::random::engine_array<Engine> streams(&engines[0], &engines[0] + engines.size());
+    BOOST_CHECK_EQUAL( streams.size(), engines.size() );
+
+    std::vector<typename Engine::result_type> out(engines.size());
+    std::vector<bool> mask(engines.size());
+    for (std::size_t draw=0; draw<3*Engine::samples_per_block + 3; ++draw) {
+        if (draw % 3 == 2) {
+            // every stream whose index shares a bit with the draw number
+            for (std::size_t i=0; i<engines.size(); ++i)
+                mask[i] = ((i + 1) & draw) != 0;
+            std::fill(out.begin(), out.end(), 0);
+            streams.draw(&out[0], mask);
+            for (std::size_t i=0; i<engines.size(); ++i)
+                BOOST_CHECK_EQUAL( out[i], mask[i] ? engines[i]() : 0 );
+        }
+        else {
+            streams.draw(&out[0]);
+            for (std::size_t i=0; i<engines.size(); ++i)
+                BOOST_CHECK_EQUAL( out[i], engines[i]() );
+        }
+    }
+    for (std::size_t i=0; i<engines.size(); ++i)
+        BOOST_CHECK( streams.get(i) == engines[i] );
+
+    // set and get a single stream
+    Engine eng(77);
+    eng.discard(3);
+    streams.set(4, eng);
+    BOOST_CHECK( streams.get(4) == eng );
+    streams.draw(&out[0]);
+    BOOST_CHECK_EQUAL( out[4], eng() );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_engine_array )
+{
+    check_engine_array< boost::random::threefry4x64_engine<boost::uint8_t, 8, 13> >();
+    check_engine_array< boost::random::threefry4x64_engine<boost::uint16_t, 16, 20, 2, 3> >();
+    check_engine_array< boost::random::threefry4x64_13 >();
+    check_engine_array< boost::random::threefry4x64_20_64 >();
+    check_engine_array< boost::random::threefry4x64_engine<boost::uint64_t, 64, 72> >();
+
+    // default streams are the substreams of the default engine
+    boost::random::engine_array<boost::random::threefry4x64_13_64> defaults(3);
+    boost::uint64_t out[3];
+    defaults.draw(out);
+    BOOST_CHECK_EQUAL( out[0], boost::random::threefry4x64_13_64()() );
+    BOOST_CHECK_EQUAL( out[2], boost::random::threefry4x64_13_64().substream(2)() );
+    BOOST_CHECK( out[0] != out[1] );
+
+    // an empty array draws nothing
+    boost::random::engine_array<boost::random::threefry4x64_13_64> empty;
+    BOOST_CHECK_EQUAL( empty.size(), 0u );
+    empty.draw(out);
+    BOOST_CHECK_EQUAL( out[0], boost::random::threefry4x64_13_64()() );
+}
+
 
 
 BOOST_AUTO_TEST_CASE( threefry4x64_72_64_0x00 )
@@ -573,3 +925,1450 @@ BOOST_AUTO_TEST_CASE( threefry4x64_72_64_seed_test1 )
     BOOST_CHECK_EQUAL( eng1(), eng2() );
     BOOST_CHECK_EQUAL( eng1(), eng2() );
 }
+
+BOOST_AUTO_TEST_CASE( threefry4x64_13_64_generate_blocks )
+{
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, 13> eng1;
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, 13> eng2;
+
+    boost::uint64_t blocks[4*5];
+    eng1.generate_blocks(blocks, 5);
+    
+    for (std::size_t i=0; i<4*5; ++i)
+        BOOST_CHECK_EQUAL( blocks[i], eng2() );
+    BOOST_CHECK( eng1 == eng2 );
+
+    // the rest of a partially used block gets skipped
+    eng1();
+    eng1.generate_blocks(blocks, 1);
+    eng2.discard(4);
+    for (std::size_t i=0; i<4; ++i)
+        BOOST_CHECK_EQUAL( blocks[i], eng2() );
+    BOOST_CHECK( eng1 == eng2 );
+}
+
+// generate() of n words through a generic or a contiguous iterator
+template<class Engine>
+struct generate_values
+{
+    generate_values(std::size_t n_, bool contiguous_) : n(n_), contiguous(contiguous_) {}
+
+    void operator()(Engine& eng, const std::vector<typename Engine::result_type>& expected) const
+    {
+        std::vector<boost::uint32_t> v(n+1);
+        if (contiguous)
+            eng.generate(&v[0], &v[0] + n);
+        else
+            eng.generate(v.begin(), v.begin() + n);
+        const std::vector<boost::uint32_t> words = generate_words<Engine>(expected, n);
+        BOOST_CHECK( std::equal(words.begin(), words.end(), v.begin()) );
+        BOOST_CHECK_EQUAL( v[n], 0u );
+    }
+
+    std::size_t n;
+    bool contiguous;
+};
+
+template<class Engine>
+void check_bulk_generate(std::size_t skip, std::size_t n)
+{
+    check_matches_operator<Engine>(skip, generate_draws<Engine>(n), generate_values<Engine>(n, false));
+    check_matches_operator<Engine>(skip, generate_draws<Engine>(n), generate_values<Engine>(n, true));
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_bulk_generate )
+{
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 13> engine64;
+    typedef boost::random::threefry4x64_engine<boost::uint32_t, 32, 20> engine32;
+    typedef boost::random::threefry4x64_engine<boost::uint32_t, 16, 20> engine16;
+    
+    std::size_t sizes[] = {1, 2, 7, 8, 9, 127, 128, 129, 1001};
+    for (std::size_t skip=0; skip<9; ++skip) {
+        for (std::size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); ++i) {
+            check_bulk_generate<engine64>(skip, sizes[i]);
+            check_bulk_generate<engine32>(skip, sizes[i]);
+            check_bulk_generate<engine16>(skip, sizes[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_13_64_generate_blocks_kat )
+{
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, 13> eng;
+
+    // position the engine at the end of the block before counter ff..ff, the
+    // second block wraps the counter to zero
+    std::ostringstream os;
+    os << 0xffffffffffffffff << ' ' << 0xffffffffffffffff << ' ' << 0xffffffffffffffff << ' ' << 0xffffffffffffffff << ' '
+       << 0xfffffffffffffffe << ' ' << 0xffffffffffffffff << ' ' << 0xffffffffffffffff << ' ' << 0xffffffffffffffff << ' ' << 4;
+    std::istringstream is( os.str() );
+    is >> eng;
+    
+    boost::uint64_t blocks[4*2];
+    eng.generate_blocks(blocks, 2);
+    
+    BOOST_CHECK_EQUAL( blocks[0], 0x7eaed935479722b5 );
+    BOOST_CHECK_EQUAL( blocks[1], 0x90994358c429f31c );
+    BOOST_CHECK_EQUAL( blocks[2], 0x496381083e07a75b );
+    BOOST_CHECK_EQUAL( blocks[3], 0x627ed0d746821121 );
+    
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, 13> eng0;
+    std::ostringstream os0;
+    os0 << 0xffffffffffffffff << ' ' << 0xffffffffffffffff << ' ' << 0xffffffffffffffff << ' ' << 0xffffffffffffffff << ' '
+        << 0 << ' ' << 0 << ' ' << 0 << ' ' << 0 << ' ' << 0;
+    std::istringstream is0( os0.str() );
+    is0 >> eng0;
+    for (std::size_t i=4; i<8; ++i)
+        BOOST_CHECK_EQUAL( blocks[i], eng0() );
+}
+
+// word i of the blocks that hold the values v[first], v[first+1], ...
+template<class Engine>
+boost::uint64_t block_word(const std::vector<typename Engine::result_type>& v, std::size_t first, std::size_t i)
+{
+    const std::size_t per_word = Engine::samples_per_block / 4;
+    boost::uint64_t word = 0;
+    for (std::size_t k=0; k<per_word; ++k)
+        word |= static_cast<boost::uint64_t>(v[first + per_word*i + k]) << (Engine::word_size * k);
+    return word;
+}
+
+// generate_blocks(), generate_blocks() with the key schedule of the engine,
+// or next_block() nblocks times, after the rest of a partially used block
+template<class Engine>
+struct generate_blocks_values
+{
+    generate_blocks_values(std::size_t nblocks_, bool next_block_, bool schedule_)
+    : nblocks(nblocks_), next_block(next_block_), schedule(schedule_) {}
+
+    void operator()(Engine& eng, const std::vector<typename Engine::result_type>& expected) const
+    {
+        std::vector<boost::uint64_t> blocks(4*nblocks + 1);
+        if (next_block) {
+            for (std::size_t i=0; i<nblocks; ++i) {
+                const typename Engine::block_type block = eng.next_block();
+                std::copy(block.begin(), block.end(), blocks.begin() + 4*i);
+            }
+        }
+        else if (schedule) {
+            eng.generate_blocks(eng.key_schedule(), &blocks[0], nblocks);
+        }
+        else {
+            eng.generate_blocks(&blocks[0], nblocks);
+        }
+        const std::size_t first = expected.size() - nblocks*Engine::samples_per_block;
+        for (std::size_t i=0; i<4*nblocks; ++i)
+            BOOST_CHECK_EQUAL( blocks[i], block_word<Engine>(expected, first, i) );
+        BOOST_CHECK_EQUAL( blocks[4*nblocks], 0u );
+    }
+
+    std::size_t nblocks;
+    bool next_block;
+    bool schedule;
+};
+
+template<class Engine>
+void check_generate_blocks(std::size_t skip, std::size_t nblocks, bool next_block = false, bool schedule = false)
+{
+    const std::size_t rest = (Engine::samples_per_block - skip % Engine::samples_per_block) % Engine::samples_per_block;
+    check_matches_operator<Engine>(skip, rest + nblocks*Engine::samples_per_block,
+        generate_blocks_values<Engine>(nblocks, next_block, schedule));
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_generate_blocks_lanes )
+{
+    for (std::size_t nblocks=0; nblocks<=35; ++nblocks) {
+        check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 13> >(nblocks % 5, nblocks);
+        check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 1, 1> >(nblocks % 5, nblocks);
+        check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 72, 2, 3> >(nblocks % 5, nblocks);
+        check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 7, 0, 2> >(nblocks % 5, nblocks);
+        check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 13> >(nblocks % 5, nblocks, false, true);
+        check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 1, 1> >(nblocks % 5, nblocks, false, true);
+        check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 72, 2, 3> >(nblocks % 5, nblocks, false, true);
+        check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 7, 0, 2> >(nblocks % 5, nblocks, false, true);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_generate_blocks_schedule )
+{
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 1, 1> engine_type;
+    engine_type root(0x452821e638d01377);
+    const engine_type::key_schedule_type schedule = root.key_schedule();
+
+    // the schedule encrypts like the engine, the counter words beyond
+    // CounterSize are zero
+    boost::random::threefry4x64<20>::key_type key = {{ 0x452821e638d01377, 0, 0, 0 }};
+    boost::random::threefry4x64<20>::ctr_type ctr = {{ 3, 0, 0, 0 }};
+    const boost::random::threefry4x64<20>::ctr_type out = schedule.encrypt(ctr);
+    const boost::random::threefry4x64<20>::ctr_type expected = boost::random::threefry4x64<20>::encrypt(key, ctr);
+    root.discard(4*3);
+    for (std::size_t j=0; j<4; ++j) {
+        BOOST_CHECK_EQUAL( out[j], expected[j] );
+        BOOST_CHECK_EQUAL( out[j], root() );
+    }
+
+    // one schedule for the substreams of the root, across the wrap of the
+    // single counter word at the end of the last stream
+    const boost::uint64_t streams[] = { 0, 1, 5, 0xFFFFFFFF };
+    for (std::size_t s=0; s<4; ++s) {
+        engine_type eng1 = root.substream(streams[s]);
+        eng1.discard(4 * 0xFFFFFFFDull);
+        engine_type eng2 = eng1;
+
+        boost::uint64_t blocks[4*7];
+        eng1.generate_blocks(schedule, blocks, 7);
+        for (std::size_t i=0; i<7; ++i) {
+            const engine_type::block_type block = eng2.next_block();
+            for (std::size_t j=0; j<4; ++j)
+                BOOST_CHECK_EQUAL( blocks[4*i + j], block[j] );
+        }
+        BOOST_CHECK( eng1 == eng2 );
+    }
+}
+
+// generate_blocks(), or next_block() nblocks times, of a counter_based_engine
+// whose values are the words of its blocks
+template<class Engine>
+struct counter_blocks_values
+{
+    counter_blocks_values(std::size_t nblocks_, bool next_block_) : nblocks(nblocks_), next_block(next_block_) {}
+
+    void operator()(Engine& eng, const std::vector<typename Engine::result_type>& expected) const
+    {
+        const std::size_t words = Engine::ctr_words;
+        std::vector<typename Engine::word_type> blocks(words*nblocks + 1);
+        if (next_block) {
+            for (std::size_t i=0; i<nblocks; ++i) {
+                const typename Engine::ctr_type block = eng.next_block();
+                std::copy(block.begin(), block.end(), blocks.begin() + words*i);
+            }
+        }
+        else {
+            eng.generate_blocks(&blocks[0], nblocks);
+        }
+        const std::size_t first = expected.size() - nblocks*Engine::samples_per_block;
+        for (std::size_t i=0; i<words*nblocks; ++i)
+            BOOST_CHECK_EQUAL( blocks[i], expected[first + i] );
+        BOOST_CHECK_EQUAL( blocks[words*nblocks], 0u );
+    }
+
+    std::size_t nblocks;
+    bool next_block;
+};
+
+template<class Engine>
+void check_counter_blocks(std::size_t skip, std::size_t nblocks, bool next_block = false)
+{
+    BOOST_STATIC_ASSERT( Engine::word_size == Engine::cipher_type::word_bits );
+    const std::size_t rest = (Engine::samples_per_block - skip % Engine::samples_per_block) % Engine::samples_per_block;
+    check_matches_operator<Engine>(skip, rest + nblocks*Engine::samples_per_block,
+        counter_blocks_values<Engine>(nblocks, next_block));
+}
+
+// threefry4x32 generate_blocks() across the carry out of the first counter word
+void check_threefry4x32_carry()
+{
+    typedef boost::random::threefry4x32<20> threefry;
+    boost::random::threefry4x32_20 eng;
+    std::istringstream is("1 2 3 4 4294967280 4294967295 5 0 4");
+    is >> eng;
+    const std::size_t n = 40;
+    boost::uint32_t blocks[4*n];
+    eng.generate_blocks(blocks, n);
+
+    const threefry::key_type key = {{ 1, 2, 3, 4 }};
+    threefry::ctr_type ctr = {{ 4294967281u, 4294967295u, 5, 0 }};
+    for (std::size_t i=0; i<n; ++i) {
+        const threefry::ctr_type out = threefry::encrypt(key, ctr);
+        for (std::size_t j=0; j<4; ++j)
+            BOOST_CHECK_EQUAL( blocks[4*i + j], out[j] );
+        for (std::size_t j=0; j<4; ++j)
+            if (++ctr[j] != 0) break;
+    }
+    BOOST_CHECK_EQUAL( ctr[2], 6u );
+    BOOST_CHECK_EQUAL( eng(), (threefry::encrypt(key, ctr)[0]) );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_isa )
+{
+    typedef boost::random::threefry4x64<20> threefry;
+    const threefry::key_type key = {{ 0x452821e638d01377, 0xbe5466cf34e90c6c, 0xbe5466cf34e90c6c, 0xc0ac29b7c97c50dd }};
+    const threefry::ctr_type pi = {{ 0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89 }};
+    const boost::random::threefry4x64_key_schedule<20> schedule(key);
+    const boost::random::threefry4x64_isa isas[] = { boost::random::threefry4x64_isa_scalar,
+        boost::random::threefry4x64_isa_sse2, boost::random::threefry4x64_isa_avx2, boost::random::threefry4x64_isa_avx512 };
+    const boost::random::threefry4x64_isa best = boost::random::threefry4x64_current_isa();
+    BOOST_CHECK( boost::random::threefry4x64_isa_supported(boost::random::threefry4x64_isa_scalar) );
+    BOOST_CHECK( boost::random::threefry4x64_isa_supported(best) );
+
+    for (std::size_t k=0; k<sizeof(isas)/sizeof(isas[0]); ++k) {
+        if (!boost::random::threefry4x64_isa_supported(isas[k])) {
+            BOOST_CHECK( !boost::random::threefry4x64_force_isa(isas[k]) );
+            continue;
+        }
+        BOOST_CHECK( boost::random::threefry4x64_force_isa(isas[k]) );
+        BOOST_CHECK_EQUAL( boost::random::threefry4x64_current_isa(), isas[k] );
+
+        // the KAT and the following counters, compared to the single block encrypt()
+        const std::size_t n = 19;
+        boost::uint64_t blocks[4*n];
+        schedule.encrypt_blocks(pi, blocks, n);
+        BOOST_CHECK_EQUAL( blocks[0], 0xa7e8fde591651bd9 );
+        BOOST_CHECK_EQUAL( blocks[1], 0xbaafd0c30138319b );
+        BOOST_CHECK_EQUAL( blocks[2], 0x84a5c1a729e685b9 );
+        BOOST_CHECK_EQUAL( blocks[3], 0x901d406ccebc1ba4 );
+        threefry::ctr_type c = pi;
+        for (std::size_t i=0; i<n; ++i, ++c[0]) {
+            const threefry::ctr_type out = threefry::encrypt(key, c);
+            for (std::size_t j=0; j<4; ++j)
+                BOOST_CHECK_EQUAL( blocks[4*i + j], out[j] );
+        }
+
+        // unrelated counters
+        threefry::ctr_type ctr[n];
+        threefry::ctr_type out[n];
+        for (std::size_t i=0; i<n; ++i) {
+            const threefry::ctr_type ci = {{ pi[0] * i, pi[1] + i, i, pi[3] ^ i }};
+            ctr[i] = ci;
+        }
+        schedule.encrypt(ctr, ctr + n, out);
+        for (std::size_t i=0; i<n; ++i)
+            BOOST_CHECK( out[i] == threefry::encrypt(key, ctr[i]) );
+
+        // the engines and the streams of an engine_array
+        for (std::size_t nblocks=0; nblocks<=n; ++nblocks) {
+            check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 13> >(nblocks % 5, nblocks);
+            check_generate_blocks< boost::random::threefry4x64_engine<boost::uint64_t, 64, 72, 2, 3> >(nblocks % 5, nblocks);
+        }
+        check_engine_array< boost::random::threefry4x64_20_64 >();
+
+        // the threefry4x32 lanes, also with a single round and with 72 rounds
+        for (std::size_t nblocks=0; nblocks<=2*n; ++nblocks) {
+            check_counter_blocks< boost::random::threefry4x32_20 >(nblocks % 5, nblocks);
+            check_counter_blocks< boost::random::threefry4x32_13 >(nblocks % 5, nblocks);
+            check_counter_blocks< boost::random::counter_based_engine<boost::uint32_t, 32, boost::random::threefry4x32<1> > >(nblocks % 5, nblocks);
+            check_counter_blocks< boost::random::counter_based_engine<boost::uint32_t, 32, boost::random::threefry4x32<72> > >(nblocks % 5, nblocks);
+        }
+        check_threefry4x32_carry();
+    }
+
+    BOOST_CHECK( boost::random::threefry4x64_force_isa(boost::random::threefry4x64_isa_auto) );
+    BOOST_CHECK_EQUAL( boost::random::threefry4x64_current_isa(), best );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_encrypt )
+{
+    boost::random::threefry4x64<13>::key_type key0 = {{ 0, 0, 0, 0 }};
+    boost::random::threefry4x64<13>::ctr_type ctr0 = {{ 0, 0, 0, 0 }};
+    boost::random::threefry4x64<13>::ctr_type out = boost::random::threefry4x64<13>::encrypt(key0, ctr0);
+    BOOST_CHECK_EQUAL( out[0], 0x4071fabee1dc8e05 );
+    BOOST_CHECK_EQUAL( out[1], 0x02ed3113695c9c62 );
+    BOOST_CHECK_EQUAL( out[2], 0x397311b5b89f9d49 );
+    BOOST_CHECK_EQUAL( out[3], 0xe21292c3258024bc );
+    
+    boost::random::threefry4x64<20>::key_type keyff = {{ 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff }};
+    boost::random::threefry4x64<20>::ctr_type ctrff = {{ 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff }};
+    out = boost::random::threefry4x64<20>::encrypt(keyff, ctrff);
+    BOOST_CHECK_EQUAL( out[0], 0x29c24097942bba1b );
+    BOOST_CHECK_EQUAL( out[1], 0x0371bbfb0f6f4e11 );
+    BOOST_CHECK_EQUAL( out[2], 0x3c231ffa33f83a1c );
+    BOOST_CHECK_EQUAL( out[3], 0xcd29113fde32d168 );
+
+    boost::random::threefry4x64<72>::key_type key45 = {{ 0x452821e638d01377, 0xbe5466cf34e90c6c, 0xbe5466cf34e90c6c, 0xc0ac29b7c97c50dd }};
+    boost::random::threefry4x64<72>::ctr_type ctr24 = {{ 0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89 }};
+    out = boost::random::threefry4x64<72>::encrypt(key45, ctr24);
+    BOOST_CHECK_EQUAL( out[0], 0xacf412ccaa3b2270 );
+    BOOST_CHECK_EQUAL( out[1], 0xc9e99bd53f2e9173 );
+    BOOST_CHECK_EQUAL( out[2], 0x43dad469dc825948 );
+    BOOST_CHECK_EQUAL( out[3], 0xfbb19d06c8a2b4dc );
+}
+
+#ifndef BOOST_NO_CXX14_CONSTEXPR
+// encrypt() in constant expressions: the KATs at compile time, and a table of
+// the first 16 values of an engine seeded with 42
+typedef boost::random::threefry4x64<13> threefry13;
+typedef boost::random::threefry4x64<72> threefry72;
+constexpr threefry13::ctr_type constexpr_out13 = threefry13::encrypt(threefry13::key_type{{ 0, 0, 0, 0 }}, threefry13::ctr_type{{ 0, 0, 0, 0 }});
+BOOST_STATIC_ASSERT( constexpr_out13.elems[0] == 0x4071fabee1dc8e05 );
+BOOST_STATIC_ASSERT( constexpr_out13.elems[3] == 0xe21292c3258024bc );
+constexpr threefry72::ctr_type constexpr_out72 = threefry72::encrypt(
+    threefry72::key_type{{ 0x452821e638d01377, 0xbe5466cf34e90c6c, 0xbe5466cf34e90c6c, 0xc0ac29b7c97c50dd }},
+    threefry72::ctr_type{{ 0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89 }});
+BOOST_STATIC_ASSERT( constexpr_out72.elems[0] == 0xacf412ccaa3b2270 );
+BOOST_STATIC_ASSERT( constexpr_out72.elems[3] == 0xfbb19d06c8a2b4dc );
+
+struct constexpr_table
+{
+    boost::uint64_t v[16];
+};
+
+constexpr constexpr_table make_constexpr_table(boost::uint64_t seed)
+{
+    constexpr_table table = {};
+    for (std::size_t i=0; i<4; ++i) {
+        const boost::random::threefry4x64<20>::ctr_type block = boost::random::threefry4x64<20>::encrypt(
+            boost::random::threefry4x64<20>::key_type{{ seed, 0, 0, 0 }}, boost::random::threefry4x64<20>::ctr_type{{ i, 0, 0, 0 }});
+        for (std::size_t j=0; j<4; ++j)
+            table.v[4*i + j] = block.elems[j];
+    }
+    return table;
+}
+
+constexpr constexpr_table table42 = make_constexpr_table(42);
+BOOST_STATIC_ASSERT( table42.v[0] != table42.v[1] );
+
+BOOST_AUTO_TEST_CASE( threefry4x64_constexpr )
+{
+    boost::random::threefry4x64_20_64 eng(42);
+    for (std::size_t i=0; i<16; ++i)
+        BOOST_CHECK_EQUAL( table42.v[i], eng() );
+}
+#endif
+
+BOOST_AUTO_TEST_CASE( threefry4x64_encrypt_engine )
+{
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 2, 2> eng;
+    std::istringstream is( "123 456 789 0 0" );
+    is >> eng;
+    eng.discard(4*1000);
+
+    boost::random::threefry4x64<20>::key_type key = {{ 123, 456, 0, 0 }};
+    boost::random::threefry4x64<20>::ctr_type ctr = {{ 789 + 1000, 0, 0, 0 }};
+    boost::random::threefry4x64<20>::ctr_type out = boost::random::threefry4x64<20>::encrypt(key, ctr);
+    for (std::size_t i=0; i<4; ++i)
+        BOOST_CHECK_EQUAL( out[i], eng() );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_key_schedule )
+{
+    typedef boost::random::threefry4x64<20> threefry;
+    threefry::key_type key = {{ 0x452821e638d01377, 0xbe5466cf34e90c6c, 0xbe5466cf34e90c6c, 0xc0ac29b7c97c50dd }};
+    threefry::ctr_type ctr = {{ 0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89 }};
+    const boost::random::threefry4x64_key_schedule<20> schedule(key);
+    
+    threefry::ctr_type out = schedule.encrypt(ctr);
+    BOOST_CHECK_EQUAL( out[0], 0xa7e8fde591651bd9 );
+    BOOST_CHECK_EQUAL( out[1], 0xbaafd0c30138319b );
+    BOOST_CHECK_EQUAL( out[2], 0x84a5c1a729e685b9 );
+    BOOST_CHECK_EQUAL( out[3], 0x901d406ccebc1ba4 );
+
+    // consecutive counters, carrying into the second and third counter word
+    threefry::ctr_type first = {{ 0xfffffffffffffffb, 0xffffffffffffffff, 7, 8 }};
+    boost::uint64_t blocks[4*21];
+    schedule.encrypt_blocks(first, blocks, 21);
+    
+    threefry::ctr_type c = first;
+    for (std::size_t i=0; i<21; ++i) {
+        out = threefry::encrypt(key, c);
+        for (std::size_t j=0; j<4; ++j)
+            BOOST_CHECK_EQUAL( blocks[4*i + j], out[j] );
+        if (++c[0] == 0 && ++c[1] == 0) ++c[2];
+    }
+}
+
+template<class Engine>
+struct parallel_generate_values
+{
+    parallel_generate_values(std::size_t n_, unsigned int threads_) : n(n_), threads(threads_) {}
+
+    void operator()(Engine& eng, const std::vector<typename Engine::result_type>& expected) const
+    {
+        std::vector<boost::uint32_t> v(n+1);
+        boost::random::parallel_generate(eng, &v[0], &v[0] + n, threads);
+        const std::vector<boost::uint32_t> words = generate_words<Engine>(expected, n);
+        BOOST_CHECK( std::equal(words.begin(), words.end(), v.begin()) );
+        BOOST_CHECK_EQUAL( v[n], 0u );
+    }
+
+    std::size_t n;
+    unsigned int threads;
+};
+
+template<class Engine>
+void check_parallel_generate(std::size_t skip, std::size_t n, unsigned int threads)
+{
+    check_matches_operator<Engine>(skip, generate_draws<Engine>(n), parallel_generate_values<Engine>(n, threads));
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_parallel_generate )
+{
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 13> engine64;
+    typedef boost::random::threefry4x64_engine<boost::uint32_t, 32, 20, 1, 1> engine32;
+    typedef boost::random::threefry4x64_engine<boost::uint32_t, 8, 20> engine8;
+
+    std::size_t sizes[] = {1, 5, 8*1024*3 - 1, 8*1024*7 + 3};
+    for (unsigned int threads=1; threads<=8; ++threads) {
+        for (std::size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); ++i) {
+            check_parallel_generate<engine64>(3, sizes[i], threads);
+            check_parallel_generate<engine32>(5, sizes[i], threads);
+            check_parallel_generate<engine8>(threads, sizes[i], threads);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_substream )
+{
+    typedef boost::random::threefry4x64<20> threefry;
+    threefry::key_type key = {{ 0x452821e638d01377, 0xbe5466cf34e90c6c, 0, 0 }};
+
+    std::ostringstream os;
+    os << key[0] << ' ' << key[1] << ' ' << 0 << ' ' << 0 << ' ' << 0 << ' ' << 0 << ' ' << 0;
+    std::istringstream is( os.str() );
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 2, 4> root;
+    is >> root;
+    BOOST_CHECK_EQUAL( root.stream(), 0 );
+
+    // the stream is the most significant counter word
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 2, 4> eng4 = root.substream(5);
+    BOOST_CHECK_EQUAL( eng4.stream(), 5 );
+    BOOST_CHECK( eng4 != root );
+    threefry::ctr_type ctr4 = {{ 0, 0, 0, 5 }};
+    threefry::ctr_type out = threefry::encrypt(key, ctr4);
+    for (std::size_t i=0; i<4; ++i)
+        BOOST_CHECK_EQUAL( eng4(), out[i] );
+    BOOST_CHECK_EQUAL( eng4.stream(), 5 );
+    
+    // with a single counter word the stream is the upper half of the word
+    std::istringstream is1( os.str() );
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 2, 1> eng1;
+    is1 >> eng1;
+    eng1.seek_stream(7);
+    BOOST_CHECK_EQUAL( eng1.stream(), 7 );
+    threefry::ctr_type ctr1 = {{ 0x0000000700000000, 0, 0, 0 }};
+    out = threefry::encrypt(key, ctr1);
+    for (std::size_t i=0; i<4; ++i)
+        BOOST_CHECK_EQUAL( eng1(), out[i] );
+    
+    // the end of stream 7 is the start of stream 8
+    eng1.seek_stream(7);
+    eng1.discard(4 * 0x100000000ull - 1);
+    BOOST_CHECK_EQUAL( eng1.stream(), 7 );
+    eng1();
+    BOOST_CHECK_EQUAL( eng1.stream(), 8 );
+    BOOST_CHECK( eng1 == eng1.substream(8) );
+}
+
+// discard() of a position_type as many values
+template<class Engine>
+struct discard_values
+{
+    void operator()(Engine& eng, const std::vector<typename Engine::result_type>& expected) const
+    {
+        typename Engine::position_type z = typename Engine::position_type();
+        z[0] = expected.size();
+        eng.discard(z);
+    }
+};
+
+// seek(tell()) before drawing the values
+template<class Engine>
+struct seek_values
+{
+    void operator()(Engine& eng, const std::vector<typename Engine::result_type>& expected) const
+    {
+        eng.seek(eng.tell());
+        for (std::size_t i=0; i<expected.size(); ++i)
+            BOOST_CHECK_EQUAL( eng(), expected[i] );
+    }
+};
+
+template<class Engine>
+void check_seek(std::size_t skip)
+{
+    typedef typename Engine::position_type position;
+
+    // tell() counts the values drawn
+    Engine eng1;
+    position p = eng1.tell();
+    for (std::size_t i=0; i<p.size(); ++i)
+        BOOST_CHECK_EQUAL( p[i], 0u );
+    for (std::size_t i=0; i<skip; ++i)
+        eng1();
+    p = eng1.tell();
+    BOOST_CHECK_EQUAL( p[0], skip );
+    for (std::size_t i=1; i<p.size(); ++i)
+        BOOST_CHECK_EQUAL( p[i], 0u );
+
+    // the multi-word discard equals drawing, seek(tell()) keeps the sequence
+    check_matches_operator<Engine>(skip, skip, discard_values<Engine>());
+    check_matches_operator<Engine>(skip, skip, seek_values<Engine>());
+
+    // the carry goes through all counter words
+    position last = position();
+    for (std::size_t i=0; i+1<last.size(); ++i)
+        last[i] = 0xFFFFFFFFFFFFFFFF;
+    last[last.size()-1] = Engine::samples_per_block - 1;
+    Engine eng4;
+    eng4.seek(last);
+    BOOST_CHECK( eng4.tell() == last );
+    position rest = position();
+    rest[0] = Engine::samples_per_block;
+    eng4.discard(rest);
+    rest[0] = Engine::samples_per_block - 1;
+    BOOST_CHECK( eng4.tell() == rest );
+
+    // the end of the cycle is the start
+    Engine eng5;
+    eng5.seek(last);
+    eng5();
+    BOOST_CHECK( eng5 == Engine() );
+    eng5.seek(last);
+    position one = position();
+    one[0] = 1;
+    eng5.discard(one);
+    BOOST_CHECK( eng5 == Engine() );
+    for (std::size_t i=0; i<skip; ++i)
+        eng5();
+    eng5.discard(last);
+    BOOST_CHECK( eng5.tell()[0] == skip - 1 );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_seek )
+{
+    check_seek<boost::random::threefry4x64_engine<boost::uint8_t, 8, 13, 1, 1> >(77);
+    check_seek<boost::random::threefry4x64_engine<boost::uint16_t, 16, 13, 2, 2> >(77);
+    check_seek<boost::random::threefry4x64_engine<boost::uint32_t, 32, 20, 4, 3> >(77);
+    check_seek<boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 4, 4> >(77);
+
+    // a position beyond 64 bits
+    typedef boost::random::threefry4x64<20> threefry;
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 1, 4> engine;
+    engine eng(42);
+    engine::position_type p = {{ 0x0000000000000006, 0x0000000000000001, 0x8000000000000000, 0xC000000000000000, 0x2 }};
+    eng.seek(p);
+    BOOST_CHECK( eng.tell() == p );
+    threefry::key_type key = {{ 42, 0, 0, 0 }};
+    threefry::ctr_type ctr = {{ 0x4000000000000001, 0x0000000000000000, 0x2000000000000000, 0xB000000000000000 }};
+    threefry::ctr_type out = threefry::encrypt(key, ctr);
+    BOOST_CHECK_EQUAL( eng(), out[2] );
+    BOOST_CHECK_EQUAL( eng(), out[3] );
+    BOOST_CHECK_EQUAL( eng.stream(), 0xB000000000000000 );
+
+    // a jump of 2^64 values is 2^62 blocks
+    engine eng2(42);
+    engine::position_type z = {{ 0, 1, 0, 0, 0 }};
+    eng2.discard(z);
+    threefry::ctr_type ctr2 = {{ 0x4000000000000000, 0, 0, 0 }};
+    BOOST_CHECK_EQUAL( eng2(), (threefry::encrypt(key, ctr2)[0]) );
+}
+
+// sets an element of a destination to the value of a view at its index
+template<class View>
+struct view_element
+{
+    view_element(const View& view_, const typename View::result_type* first_) : view(view_), first(first_) {}
+
+    void operator()(typename View::result_type& x) const
+    { x = view[static_cast<typename View::size_type>(&x - first)]; }
+
+    const View& view;
+    const typename View::result_type* first;
+};
+
+// the values of a view of the engine, the engine continues after them
+template<class Engine>
+struct view_values
+{
+    void operator()(Engine& eng, const std::vector<typename Engine::result_type>& expected) const
+    {
+        typedef boost::random::engine_view<Engine> view_type;
+        const std::size_t n = expected.size();
+        const Engine start(eng);
+        const view_type view(eng, n);
+        BOOST_CHECK_EQUAL( view.size(), n );
+
+        for (std::size_t i=0; i<n; ++i)
+            BOOST_CHECK_EQUAL( view[i], expected[i] );
+        BOOST_CHECK_EQUAL( std::distance(view.begin(), view.end()), static_cast<std::ptrdiff_t>(n) );
+        BOOST_CHECK( std::equal(view.begin(), view.end(), expected.begin()) );
+
+        // backwards, and with jumps
+        typename view_type::const_iterator it = view.end();
+        for (std::size_t i=n; i>0; --i)
+            BOOST_CHECK_EQUAL( *--it, expected[i-1] );
+        BOOST_CHECK( it == view.begin() );
+        for (std::size_t i=0; i<n; i+=7)
+            BOOST_CHECK_EQUAL( it[i], expected[i] );
+        BOOST_CHECK_EQUAL( *(it + (n-1)), expected[n-1] );
+        BOOST_CHECK( view.begin() < view.end() );
+
+        // a subrange starts at its first value
+        const view_type sub = view.subrange(3, n-2);
+        BOOST_CHECK_EQUAL( sub.size(), n-5 );
+        BOOST_CHECK( std::equal(sub.begin(), sub.end(), expected.begin() + 3) );
+        BOOST_CHECK( sub.engine(0) == view.engine(3) );
+
+        // the view doesn't change the engine, its end is where operator() ends
+        BOOST_CHECK( eng == start );
+        eng = view.engine(n);
+    }
+};
+
+template<class Engine>
+void check_view(std::size_t skip, std::size_t n)
+{
+    check_matches_operator<Engine>(skip, n, view_values<Engine>());
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_view )
+{
+    check_view<boost::random::threefry4x64_engine<boost::uint8_t, 8, 13, 1, 1> >(5, 200);
+    check_view<boost::random::threefry4x64_engine<boost::uint16_t, 16, 13, 2, 2> >(17, 100);
+    check_view<boost::random::threefry4x64_engine<boost::uint32_t, 32, 20, 4, 3> >(0, 50);
+    check_view<boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 4, 4> >(3, 50);
+
+    // the blocks carry over all counter words
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 1, 4> engine;
+    engine eng(42);
+    engine::position_type p = {{ 0xFFFFFFFFFFFFFFFE, 0x3, 0, 0, 0 }};
+    eng.seek(p);
+    const boost::random::engine_view<engine> view(eng);
+    typedef boost::random::threefry4x64<20> threefry;
+    threefry::key_type key = {{ 42, 0, 0, 0 }};
+    threefry::ctr_type ctr = {{ 0, 1, 0, 0 }};
+    BOOST_CHECK_EQUAL( view[2], (threefry::encrypt(key, ctr)[0]) );
+    BOOST_CHECK_EQUAL( view[0], eng() );
+    ctr[0] = 0x40000000;
+    BOOST_CHECK_EQUAL( view[0x100000005ull], (threefry::encrypt(key, ctr)[3]) );
+
+    // values instead of references: an input iterator to the legacy requirements
+    typedef std::iterator_traits<boost::random::engine_view<engine>::const_iterator> traits;
+    BOOST_STATIC_ASSERT(( boost::is_same<traits::iterator_category, std::input_iterator_tag>::value ));
+
+#if defined(__cpp_lib_ranges) && __cpp_lib_ranges >= 201911L
+    BOOST_STATIC_ASSERT( std::random_access_iterator<boost::random::engine_view<engine>::const_iterator> );
+    BOOST_STATIC_ASSERT( std::ranges::random_access_range<boost::random::engine_view<engine> > );
+
+    // the indices of std::views::iota are not forward iterators either
+    typedef std::ranges::iterator_t<std::ranges::iota_view<std::size_t, std::size_t> > iota_iterator;
+    BOOST_STATIC_ASSERT(( !boost::is_base_of<std::forward_iterator_tag, std::iterator_traits<iota_iterator>::iterator_category>::value ));
+#endif
+
+    // parallel algorithms index the view through the destination
+    const std::size_t n = 1000;
+    typedef boost::random::engine_view<engine> view_type;
+    const view_type view2(eng, n);
+    const std::vector<boost::uint64_t> expected(view2.begin(), view2.end());
+    std::vector<boost::uint64_t> out(n);
+    std::for_each(out.begin(), out.end(), view_element<view_type>(view2, &out[0]));
+    BOOST_CHECK( out == expected );
+
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_LAMBDAS)
+    std::vector<boost::uint64_t> out2(n);
+    std::vector<std::thread> workers;
+    for (std::size_t t=0; t<4; ++t) {
+        workers.push_back(std::thread([&view2, &out2, n, t]() {
+            std::for_each(out2.begin() + t*n/4, out2.begin() + (t+1)*n/4, view_element<view_type>(view2, &out2[0]));
+        }));
+    }
+    for (std::size_t t=0; t<4; ++t)
+        workers[t].join();
+    BOOST_CHECK( out2 == expected );
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_pool )
+{
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 2, 4> engine;
+    engine root(99);
+    
+    // acquire() hands out the next stream of the root key
+    boost::random::engine_pool<engine> pool(root, 10);
+    BOOST_CHECK_EQUAL( pool.next_stream(), 10u );
+    engine eng1 = pool.acquire();
+    engine eng2 = pool.acquire();
+    BOOST_CHECK( eng1 == root.substream(10) );
+    BOOST_CHECK( eng2 == root.substream(11) );
+    BOOST_CHECK_EQUAL( pool.next_stream(), 12u );
+    BOOST_CHECK( eng1() != eng2() );
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_THREAD_LOCAL) && !defined(BOOST_NO_CXX11_HDR_THREAD)
+    // local() is the same engine for a thread, in a cache line of its own
+    engine& local = pool.local();
+    BOOST_CHECK( &local == &pool.local() );
+    BOOST_CHECK_EQUAL( reinterpret_cast<boost::uintptr_t>(&local) % 64, 0u );
+    BOOST_CHECK_EQUAL( local.stream(), 12u );
+    local();
+    BOOST_CHECK( pool.local() != root.substream(12) );
+    
+    // another pool gives the thread another engine
+    boost::random::engine_pool<engine> pool2(root, 10);
+    BOOST_CHECK( &pool2.local() != &local );
+    BOOST_CHECK( pool2.local() == root.substream(10) );
+
+    // the engine of a destroyed pool is freed on the next miss
+    typedef boost::random::engine_pool<engine> pool_type;
+    const std::size_t slots = pool_type::local_engines_size();
+    {
+        boost::random::engine_pool<engine> pool3(root, 20);
+        pool3.local();
+        BOOST_CHECK_EQUAL( pool_type::local_engines_size(), slots + 1 );
+    }
+    BOOST_CHECK( pool.local() != root.substream(12) );
+    BOOST_CHECK_EQUAL( pool_type::local_engines_size(), slots );
+
+    // every thread gets its own stream
+    const std::size_t threads = 4;
+    std::vector<boost::uint_least64_t> streams(threads);
+    std::vector<std::thread> workers;
+    for (std::size_t t=0; t<threads; ++t) {
+        workers.push_back(std::thread([&pool, &streams, t]() {
+            streams[t] = pool.local().stream();
+            for (int i=0; i<1000; ++i)
+                pool.local()();
+        }));
+    }
+    for (std::size_t t=0; t<threads; ++t)
+        workers[t].join();
+    std::sort(streams.begin(), streams.end());
+    for (std::size_t t=0; t<threads; ++t)
+        BOOST_CHECK_EQUAL( streams[t], 13 + t );
+    BOOST_CHECK_EQUAL( pool.next_stream(), 13 + threads );
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_pool_streams_exhausted )
+{
+    // with a single counter word there are 2^32 streams
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 2, 1> engine;
+    engine root(99);
+    boost::random::engine_pool<engine> pool(root, 0xFFFFFFFF);
+    BOOST_CHECK( pool.acquire() == root.substream(0xFFFFFFFF) );
+    BOOST_CHECK_THROW( pool.acquire(), std::out_of_range );
+    BOOST_CHECK_THROW( pool.acquire(), std::out_of_range );
+
+    // with more counter words there are 2^64
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 2, 2> wide_engine;
+    wide_engine wide_root(99);
+    boost::random::engine_pool<wide_engine> wide_pool(wide_root, 0xFFFFFFFF);
+    wide_pool.acquire();
+    BOOST_CHECK( wide_pool.acquire() == wide_root.substream(0x100000000ULL) );
+}
+
+// an engine with another layout produces the same values as the default one
+template<class Layout>
+void check_layout(std::size_t size)
+{
+    typedef boost::random::threefry4x64_engine<boost::uint32_t, 32, 20, 4, 4> engine;
+    typedef boost::random::threefry4x64_engine<boost::uint32_t, 32, 20, 4, 4, Layout> layout_engine;
+
+    // aligned engines fill whole multiples of the alignment
+    BOOST_CHECK_EQUAL( sizeof(layout_engine), size );
+    layout_engine engines[3];
+    if (Layout::alignment != 0) {
+        for (std::size_t i=0; i<3; ++i)
+            BOOST_CHECK_EQUAL( reinterpret_cast<boost::uintptr_t>(&engines[i]) % Layout::alignment, 0u );
+    }
+
+    engine eng1(9);
+    layout_engine eng2(9);
+    for (std::size_t i=0; i<11; ++i)
+        BOOST_CHECK_EQUAL( eng1(), eng2() );
+    eng1.discard(5);
+    eng2.discard(5);
+    std::vector<boost::uint32_t> v1(37), v2(37);
+    eng1.generate(&v1[0], &v1[0] + v1.size());
+    eng2.generate(&v2[0], &v2[0] + v2.size());
+    BOOST_CHECK( v1 == v2 );
+    eng1.fill(&v1[0], &v1[0] + v1.size());
+    eng2.fill(&v2[0], &v2[0] + v2.size());
+    BOOST_CHECK( v1 == v2 );
+    unsigned char b1[77], b2[77];
+    eng1.fill_bytes(b1, sizeof(b1));
+    eng2.fill_bytes(b2, sizeof(b2));
+    BOOST_CHECK( std::equal(b1, b1 + sizeof(b1), b2) );
+    for (std::size_t i=0; i<11; ++i)
+        BOOST_CHECK_EQUAL( eng1(), eng2() );
+
+    // the saved state doesn't depend on the layout
+    unsigned char state[engine::state_size];
+    eng2.save(state);
+    engine eng3;
+    BOOST_CHECK( eng3.load(state) );
+    BOOST_CHECK( eng3 == eng1 );
+    BOOST_CHECK_EQUAL( eng3(), eng2() );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_layout )
+{
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 4, 4> engine;
+
+    // output block, counter, key and parity word, offset
+    check_layout< boost::random::threefry4x64_layout<> >(8*(4 + 4 + 5 + 1));
+    check_layout< boost::random::threefry4x64_layout<32> >(128);
+    check_layout< boost::random::threefry4x64_layout<64> >(128);
+    check_layout< boost::random::threefry4x64_layout<0, false> >(8*(4 + 5 + 1));
+    check_layout< boost::random::threefry4x64_layout<64, false> >(128);
+    check_layout< boost::random::threefry4x64_layout<32, false> >(96);
+
+    // the bulk paths and adapters of an engine without the output block
+    typedef boost::random::threefry4x64_engine<boost::uint32_t, 32, 20, 4, 4, boost::random::threefry4x64_layout<64, false> > compact;
+    check_bulk_generate<compact>(3, 100);
+    check_generate_blocks<compact>(3, 5);
+    check_fill<compact>();
+    check_fill_bytes<compact>();
+    check_seek<compact>(5);
+    check_view<compact>(5, 40);
+
+    // engines are equal when their keys are, the parity word follows from the key
+    std::istringstream is1( "1 2 3 4 0 0 0 0 0" );
+    std::istringstream is2( "1 2 3 5 0 0 0 0 0" );
+    engine eng1;
+    engine eng2;
+    is1 >> eng1;
+    is2 >> eng2;
+    BOOST_CHECK( eng1 != eng2 );
+    std::istringstream is3( "1 2 3 5 0 0 0 0 0" );
+    is3 >> eng1;
+    BOOST_CHECK( eng1 == eng2 );
+}
+
+template<class Engine>
+void check_block_engine(std::size_t skip)
+{
+    typedef boost::random::block_engine<Engine> block_engine;
+    typedef typename Engine::block_type block_type;
+
+    // next_block() is generate_blocks() with a single block
+    check_generate_blocks<Engine>(skip, 3, true);
+
+    // the adapter starts at the next block boundary
+    Engine eng3(5);
+    eng3.discard(skip);
+    block_engine blocks1(eng3);
+    std::vector<block_type> out(5);
+    blocks1.generate(&out[0], &out[0] + 2);
+    for (std::size_t i=2; i<5; ++i)
+        out[i] = blocks1();
+    for (std::size_t i=0; i<3; ++i)
+        BOOST_CHECK( out[i] == eng3.next_block() );
+    block_engine blocks2(eng3);
+    BOOST_CHECK( blocks2() == out[3] );
+    BOOST_CHECK( blocks2 != blocks1 );
+    BOOST_CHECK( blocks2() == out[4] );
+    BOOST_CHECK( blocks2 == blocks1 );
+    BOOST_CHECK( blocks2.engine() == blocks1.engine() );
+    
+    // discard() skips whole blocks, also beyond 2^64 values
+    block_engine blocks3(eng3);
+    blocks3.discard(1);
+    BOOST_CHECK( blocks3() == out[4] );
+    block_engine blocks4(5);
+    blocks4.discard(0x4000000000000001);
+    Engine eng4(5);
+    typename Engine::position_type p = typename Engine::position_type();
+    p[0] = Engine::samples_per_block;
+    p[1] = Engine::samples_per_block / 4;
+    eng4.seek(p);
+    BOOST_CHECK( blocks4.engine() == eng4 );
+    BOOST_CHECK( blocks4() == eng4.next_block() );
+
+    // a stream round trip of a partially consumed engine continues at the next block
+    Engine eng1(5);
+    eng1.discard(skip);
+    eng1.next_block();
+    eng1();
+    std::ostringstream os;
+    os << eng1;
+    std::istringstream is(os.str());
+    block_engine blocks5;
+    is >> blocks5;
+    BOOST_CHECK( blocks5() == eng1.next_block() );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_block_engine )
+{
+    check_block_engine<boost::random::threefry4x64_engine<boost::uint8_t, 8, 13, 1, 2> >(7);
+    check_block_engine<boost::random::threefry4x64_engine<boost::uint32_t, 32, 20, 2, 4> >(0);
+    check_block_engine<boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 4, 4> >(3);
+
+    // the R20 pi KAT
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 4, 4> engine;
+    std::ostringstream os;
+    os << 0x452821e638d01377 << ' ' << 0xbe5466cf34e90c6c << ' ' << 0xbe5466cf34e90c6c << ' ' << 0xc0ac29b7c97c50dd << ' '
+       << 0x243f6a8885a308d3 << ' ' << 0x13198a2e03707344 << ' ' << 0xa4093822299f31d0 << ' ' << 0x082efa98ec4e6c89 << ' ' << 0;
+    std::istringstream is( os.str() );
+    engine eng;
+    is >> eng;
+    const engine::block_type block = eng.next_block();
+    BOOST_CHECK_EQUAL( block[0], 0xa7e8fde591651bd9 );
+    BOOST_CHECK_EQUAL( block[1], 0xbaafd0c30138319b );
+    BOOST_CHECK_EQUAL( block[2], 0x84a5c1a729e685b9 );
+    BOOST_CHECK_EQUAL( block[3], 0x901d406ccebc1ba4 );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_lazy_encryption )
+{
+    typedef boost::random::threefry4x64_engine<boost::uint64_t, 64, 13, 1, 1> engine;
+    
+    engine eng1;
+    engine eng2;
+    eng1.discard(1000);
+    eng1.discard(1);
+    eng1.discard(2);
+    eng2.discard(1003);
+    BOOST_CHECK( eng1 == eng2 );
+
+    // a positioned engine survives a round trip through a stream before the first draw
+    std::ostringstream os;
+    os << eng1;
+    BOOST_CHECK_EQUAL( os.str(), "0 250 3" );
+    engine eng3;
+    std::istringstream is( os.str() );
+    is >> eng3;
+    BOOST_CHECK( eng1 == eng3 );
+    
+    boost::random::threefry4x64<13>::key_type key = {{ 0, 0, 0, 0 }};
+    boost::random::threefry4x64<13>::ctr_type ctr = {{ 250, 0, 0, 0 }};
+    BOOST_CHECK_EQUAL( eng1(), (boost::random::threefry4x64<13>::encrypt(key, ctr)[3]) );
+    BOOST_CHECK_EQUAL( eng2(), eng3() );
+
+    // the end of a block is the start of the next one
+    engine eng4;
+    eng4.discard(4);
+    std::istringstream is5( "0 1 0" );
+    engine eng5;
+    is5 >> eng5;
+    BOOST_CHECK( eng4 == eng5 );
+    BOOST_CHECK_EQUAL( eng4(), eng5() );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_uniform_01 )
+{
+    typedef boost::random::threefry4x64_engine<boost::uint32_t, 32, 13, 1, 1> engine;
+    engine eng1;
+    engine eng2;
+    eng1();
+    eng2();
+    
+    // 4 doubles per block from the 53 most significant bits of each word
+    std::vector<double> d(11);
+    boost::random::generate_uniform_01(eng1, &d[0], &d[0] + d.size());
+    std::vector<boost::uint64_t> blocks(4*3);
+    eng2.generate_blocks(&blocks[0], 3);
+    BOOST_CHECK( eng1 == eng2 );
+    for (std::size_t i=0; i<d.size(); ++i) {
+        BOOST_CHECK_EQUAL( d[i], std::ldexp(static_cast<double>(blocks[i] >> 11), -53) );
+        BOOST_CHECK( d[i] >= 0.0 && d[i] < 1.0 );
+    }
+    
+    // 8 floats per block, low half of a word first
+    std::vector<float> f(17);
+    boost::random::generate_uniform_01_open(eng1, &f[0], &f[0] + f.size());
+    eng2.generate_blocks(&blocks[0], 3);
+    BOOST_CHECK( eng1 == eng2 );
+    for (std::size_t i=0; i<f.size(); ++i) {
+        boost::uint32_t w = static_cast<boost::uint32_t>(blocks[i/2] >> (32*(i%2)));
+        BOOST_CHECK_EQUAL( f[i], std::ldexp(static_cast<float>(w >> 9) + 0.5f, -23) );
+        BOOST_CHECK( f[i] > 0.0f && f[i] < 1.0f );
+    }
+    
+    // the extreme bit patterns stay inside the intervals
+    boost::uint64_t extremes[2] = { 0, 0xffffffffffffffff };
+    typedef boost::random::detail::threefry4x64_uniform<double> uniform_double;
+    typedef boost::random::detail::threefry4x64_uniform<float> uniform_float;
+    BOOST_CHECK_EQUAL( uniform_double::closed_open(extremes, 0), 0.0 );
+    BOOST_CHECK( uniform_double::closed_open(extremes, 1) < 1.0 );
+    BOOST_CHECK( uniform_double::open_open(extremes, 0) > 0.0 );
+    BOOST_CHECK( uniform_double::open_open(extremes, 1) < 1.0 );
+    BOOST_CHECK_EQUAL( uniform_float::closed_open(extremes, 0), 0.0f );
+    BOOST_CHECK( uniform_float::closed_open(extremes, 2) < 1.0f );
+    BOOST_CHECK( uniform_float::open_open(extremes, 0) > 0.0f );
+    BOOST_CHECK( uniform_float::open_open(extremes, 2) < 1.0f );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_normal )
+{
+    typedef boost::random::threefry4x64_20_64 engine;
+    engine eng1;
+    engine eng2;
+    
+    // one word per double: sign, layer and the position in the layer
+    const double * const table_x = boost::random::detail::normal_table<double>::table_x;
+    std::vector<double> d(1001);
+    boost::random::generate_normal(eng1, &d[0], &d[0] + d.size(), 1.0, 2.0);
+    std::vector<boost::uint64_t> blocks(4*251);
+    eng2.generate_blocks(&blocks[0], 251);
+    BOOST_CHECK( eng1 == eng2 );
+    std::size_t fast = 0;
+    for (std::size_t i=0; i<d.size(); ++i) {
+        std::size_t layer = (blocks[i] & 0xff) >> 1;
+        double x = std::ldexp(static_cast<double>(blocks[i] >> 11), -53) * table_x[layer];
+        if (x < table_x[layer + 1]) {
+            BOOST_CHECK_EQUAL( d[i], 1.0 + 2.0 * ((blocks[i] & 1) ? -x : x) );
+            ++fast;
+        }
+    }
+    BOOST_CHECK( fast > 950 && fast < d.size() );
+
+    // the values outside the rectangles continue with bits of the rounds of the engine
+    typedef boost::random::threefry4x64_13_64 engine13;
+    engine13 eng5;
+    engine13 eng6(eng5);
+    std::vector<double> d13(4000);
+    boost::random::generate_normal(eng5, &d13[0], &d13[0] + d13.size());
+    std::vector<boost::uint64_t> blocks13(d13.size());
+    eng6.generate_blocks(&blocks13[0], d13.size()/4);
+    std::size_t rounds_dependent = 0;
+    for (std::size_t i=0; i<d13.size(); ++i) {
+        BOOST_CHECK_EQUAL( d13[i], boost::random::detail::threefry4x64_normal_value<13>(&blocks13[4*(i/4)], i%4) );
+        rounds_dependent += d13[i] != boost::random::detail::threefry4x64_normal_value<20>(&blocks13[4*(i/4)], i%4);
+    }
+    BOOST_CHECK( rounds_dependent > 0 );
+    boost::random::detail::threefry4x64_ziggurat_fallback<13> fallback(&blocks13[0], 2);
+    const boost::random::threefry4x64<13>::key_type key13 = {{ blocks13[0], blocks13[1], blocks13[2], blocks13[3] }};
+    const boost::random::threefry4x64<13>::ctr_type ctr13 = {{ 2, 0, 0, 0 }};
+    BOOST_CHECK_EQUAL( fallback(), (boost::random::threefry4x64<13>::encrypt(key13, ctr13)[0]) );
+    
+    // the values only depend on the position, not on how the range is split
+    const std::size_t n = 10000;
+    std::vector<float> f1(n);
+    std::vector<float> f2(n);
+    engine eng3(eng1);
+    boost::random::generate_normal(eng1, &f1[0], &f1[0] + n);
+    boost::random::generate_normal(eng3, &f2[0], &f2[0] + 4000);
+    engine eng4(eng3);
+    eng4.discard(engine::samples_per_block * (n - 4000) / 8);
+    boost::random::generate_normal(eng3, &f2[0] + 4000, &f2[0] + n);
+    BOOST_CHECK( f1 == f2 );
+    BOOST_CHECK( eng1 == eng3 );
+    BOOST_CHECK( eng1 == eng4 );
+    
+    // the first two moments
+    double sum = 0;
+    double sum2 = 0;
+    for (std::size_t i=0; i<n; ++i) {
+        sum += f1[i];
+        sum2 += f1[i]*f1[i];
+    }
+    BOOST_CHECK_SMALL( sum / n, 0.05 );
+    BOOST_CHECK_CLOSE( sum2 / n, 1.0, 5.0 );
+    
+    // the tails, P(|z| > 2) = 0.0455 and P(|z| > 3.5) = 0.000465
+    const std::size_t big = 1000000;
+    std::vector<double> z(big);
+    boost::random::generate_normal(eng1, &z[0], &z[0] + big);
+    std::size_t beyond2 = 0;
+    std::size_t beyond35 = 0;
+    for (std::size_t i=0; i<big; ++i) {
+        beyond2 += std::abs(z[i]) > 2.0;
+        beyond35 += std::abs(z[i]) > 3.5;
+    }
+    BOOST_CHECK_CLOSE( beyond2 / double(big), 0.0455, 3.0 );
+    BOOST_CHECK_CLOSE( beyond35 / double(big), 0.000465, 15.0 );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_hash )
+{
+    typedef boost::random::threefry4x64<20> threefry;
+    const boost::random::threefry4x64_hash<20> hash(42);
+
+    // the block of the engine seeded with 42 at counter (a, b, c, d)
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, 20, 4, 4> eng;
+    std::istringstream is( "42 0 0 0 1000 7 3 9 0" );
+    is >> eng;
+    threefry::ctr_type block = hash(1000, 7, 3, 9);
+    for (std::size_t i=0; i<4; ++i)
+        BOOST_CHECK_EQUAL( block[i], eng() );
+
+    threefry::key_type key = {{ 0x452821e638d01377, 0xbe5466cf34e90c6c, 0xbe5466cf34e90c6c, 0xc0ac29b7c97c50dd }};
+    block = boost::random::threefry4x64_hash<20>(key)(0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89);
+    BOOST_CHECK_EQUAL( block[0], 0xa7e8fde591651bd9 );
+    BOOST_CHECK_EQUAL( block[3], 0x901d406ccebc1ba4 );
+
+    // the values of a tuple are those of the first word of its block
+    double d[4];
+    std::istringstream is2( "42 0 0 0 5 6 0 0 0" );
+    is2 >> eng;
+    boost::random::generate_normal(eng, d, d + 4);
+    BOOST_CHECK_EQUAL( hash.normal(5, 6), d[0] );
+    BOOST_CHECK_EQUAL( hash.uniform_01(5, 6), std::ldexp(static_cast<double>(hash(5, 6)[0] >> 11), -53) );
+
+    // batches, a length that is not a multiple of the SIMD width
+    const std::size_t n = 1003;
+    std::vector<threefry::ctr_type> ctr(n);
+    for (std::size_t i=0; i<n; ++i) {
+        const threefry::ctr_type c = {{ i % 17, i / 17, 3, i * 0x9e3779b97f4a7c15 }};
+        ctr[i] = c;
+    }
+    std::vector<threefry::ctr_type> blocks(n);
+    std::vector<double> u(n);
+    std::vector<double> z(n);
+    hash(&ctr[0], &ctr[0] + n, &blocks[0]);
+    hash.uniform_01(&ctr[0], &ctr[0] + n, &u[0]);
+    hash.normal(&ctr[0], &ctr[0] + n, &z[0]);
+    double sum = 0;
+    double sum2 = 0;
+    for (std::size_t i=0; i<n; ++i) {
+        BOOST_CHECK( blocks[i] == hash(ctr[i][0], ctr[i][1], ctr[i][2], ctr[i][3]) );
+        BOOST_CHECK_EQUAL( u[i], hash.uniform_01(ctr[i][0], ctr[i][1], ctr[i][2], ctr[i][3]) );
+        BOOST_CHECK_EQUAL( z[i], hash.normal(ctr[i][0], ctr[i][1], ctr[i][2], ctr[i][3]) );
+        BOOST_CHECK( u[i] >= 0.0 && u[i] < 1.0 );
+        sum += z[i];
+        sum2 += z[i]*z[i];
+    }
+    BOOST_CHECK_SMALL( sum / n, 0.15 );
+    BOOST_CHECK_CLOSE( sum2 / n, 1.0, 15.0 );
+}
+
+template<class Engine>
+void check_counter_based_kat(const char* state, const char* expected)
+{
+    Engine eng;
+    std::istringstream is(state);
+    is >> eng;
+    
+    std::istringstream es(expected);
+    typename Engine::result_type value;
+    while (es >> std::hex >> value)
+        BOOST_CHECK_EQUAL( eng(), value );
+}
+
+BOOST_AUTO_TEST_CASE( threefry2x64_kat )
+{
+    // state: key words, counter words, offset
+    typedef boost::random::counter_based_engine<boost::uint64_t, 64, boost::random::threefry2x64<32> > threefry2x64_32_64;
+    check_counter_based_kat<boost::random::threefry2x64_13_64>("0 0 0 0 0", "f167b032c3b480bd e91f9fee4b7a6fb5");
+    check_counter_based_kat<boost::random::threefry2x64_13_64>("18446744073709551615 18446744073709551615 18446744073709551615 18446744073709551615 0", "ccdec5c917a874b1 4df53abca26ceb01");
+    check_counter_based_kat<boost::random::threefry2x64_13_64>("11820040416388919760 589684135938649225 2611923443488327891 1376283091369227076 0", "c3aac71561042993 3fe7ae8801aff316");
+    check_counter_based_kat<boost::random::threefry2x64_20_64>("0 0 0 0 0", "c2b6e3a8c2c69865 6f81ed42f350084d");
+    check_counter_based_kat<boost::random::threefry2x64_20_64>("18446744073709551615 18446744073709551615 18446744073709551615 18446744073709551615 0", "e02cb7c4d95d277a d06633d0893b8b68");
+    check_counter_based_kat<boost::random::threefry2x64_20_64>("11820040416388919760 589684135938649225 2611923443488327891 1376283091369227076 0", "263c7d30bb0f0af1 56be8361d3311526");
+    check_counter_based_kat<threefry2x64_32_64>("0 0 0 0 0", "38ba854d7f13cfb3 d02fca729d54fadc");
+    check_counter_based_kat<threefry2x64_32_64>("18446744073709551615 18446744073709551615 18446744073709551615 18446744073709551615 0", "6b532f4f6e288646 0388f1ec135ee18e");
+    check_counter_based_kat<threefry2x64_32_64>("11820040416388919760 589684135938649225 2611923443488327891 1376283091369227076 0", "dad492f32efbd0c4 b6d7d0cd1f193e84");
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x32_kat )
+{
+    check_counter_based_kat<boost::random::threefry4x32_13>("0 0 0 0 0 0 0 0 0", "531c7e4f 39491ee5 2c855a92 3d6abf9a");
+    check_counter_based_kat<boost::random::threefry4x32_13>("4294967295 4294967295 4294967295 4294967295 4294967295 4294967295 4294967295 4294967295 0", "c4189358 1c9cc83a d5881c67 6a0a89e0");
+    check_counter_based_kat<boost::random::threefry4x32_13>("2752067618 698298832 137296536 3964562569 608135816 2242054355 320440878 57701188 0", "4aa71d8f 734738c2 431fc6a8 ae6debf1");
+    check_counter_based_kat<boost::random::threefry4x32_20>("0 0 0 0 0 0 0 0 0", "9c6ca96a e17eae66 fc10ecd4 5256a7d8");
+    check_counter_based_kat<boost::random::threefry4x32_20>("4294967295 4294967295 4294967295 4294967295 4294967295 4294967295 4294967295 4294967295 0", "2a881696 57012287 f6c7446e a16a6732");
+    check_counter_based_kat<boost::random::threefry4x32_20>("2752067618 698298832 137296536 3964562569 608135816 2242054355 320440878 57701188 0", "59cd1dbb b8879579 86b5d00c ac8b6d84");
+}
+
+BOOST_AUTO_TEST_CASE( threefry2x32_kat )
+{
+    typedef boost::random::counter_based_engine<boost::uint32_t, 32, boost::random::threefry2x32<32> > threefry2x32_32;
+    check_counter_based_kat<boost::random::threefry2x32_13>("0 0 0 0 0", "9d1c5ec6 8bd50731");
+    check_counter_based_kat<boost::random::threefry2x32_13>("4294967295 4294967295 4294967295 4294967295 0", "fd36d048 2d17272c");
+    check_counter_based_kat<boost::random::threefry2x32_13>("320440878 57701188 608135816 2242054355 0", "ba3e4725 f27d669e");
+    check_counter_based_kat<boost::random::threefry2x32_20>("0 0 0 0 0", "6b200159 99ba4efe");
+    check_counter_based_kat<boost::random::threefry2x32_20>("4294967295 4294967295 4294967295 4294967295 0", "1cb996fc bb002be7");
+    check_counter_based_kat<boost::random::threefry2x32_20>("320440878 57701188 608135816 2242054355 0", "c4923a9c 483df7a0");
+    check_counter_based_kat<threefry2x32_32>("0 0 0 0 0", "cee3d47e a23dfd5c");
+    check_counter_based_kat<threefry2x32_32>("4294967295 4294967295 4294967295 4294967295 0", "6e2fe0d0 b1b76f82");
+    check_counter_based_kat<threefry2x32_32>("320440878 57701188 608135816 2242054355 0", "e2827716 c3c05cdf");
+}
+
+BOOST_AUTO_TEST_CASE( counter_based_engine_interface )
+{
+    // threefry4x64 as the cipher gives the threefry4x64_engine sequence
+    typedef boost::random::counter_based_engine<boost::uint32_t, 32, boost::random::threefry4x64<20> > engine;
+    engine eng1(12345);
+    boost::random::threefry4x64_engine<boost::uint32_t, 32, 20> eng2(12345);
+    for (int i=0; i<100; ++i)
+        BOOST_CHECK_EQUAL( eng1(), eng2() );
+    
+    // 64 bit values from 32 bit words, 8 bit values from 64 bit words
+    boost::random::counter_based_engine<boost::uint64_t, 64, boost::random::threefry4x32<20> > eng64;
+    boost::random::threefry4x32_20 eng32;
+    for (int i=0; i<10; ++i) {
+        boost::uint64_t lo = eng32();
+        boost::uint64_t hi = eng32();
+        BOOST_CHECK_EQUAL( eng64(), lo | (hi << 32) );
+    }
+    boost::random::counter_based_engine<boost::uint8_t, 8, boost::random::threefry2x64<20> > eng8;
+    boost::random::threefry2x64_20_64 eng2x64;
+    for (int i=0; i<4; ++i) {
+        boost::uint64_t w = eng2x64();
+        for (int j=0; j<8; ++j)
+            BOOST_CHECK_EQUAL( eng8(), (w >> (8*j)) & 0xff );
+    }
+    
+    // discard crosses counter words, 2^32 blocks of 2 values
+    boost::random::threefry2x32_20 eng3;
+    boost::random::threefry2x32_20 eng4;
+    eng3.discard(0x200000003ULL);
+    std::istringstream is("0 0 1 1 1");
+    is >> eng4;
+    BOOST_CHECK( eng3 == eng4 );
+    BOOST_CHECK_EQUAL( eng3(), eng4() );
+    
+    // stream round trip, seeding
+    std::stringstream ss;
+    ss << eng3;
+    boost::random::threefry2x32_20 eng5;
+    ss >> eng5;
+    BOOST_CHECK( eng3 == eng5 );
+    BOOST_CHECK_EQUAL( eng3(), eng5() );
+    eng5.seed(7);
+    std::istringstream is2("7 0 0 0 0");
+    is2 >> eng4;
+    BOOST_CHECK( eng4 == eng5 );
+    BOOST_CHECK( eng4 != eng3 );
+    
+    // a 64 bit seed fills two 32 bit key words
+    eng64.seed(0x100000002ULL);
+    boost::random::counter_based_engine<boost::uint64_t, 64, boost::random::threefry4x32<20> > eng6;
+    std::istringstream is3("2 1 0 0 0 0 0 0 0");
+    is3 >> eng6;
+    BOOST_CHECK( eng64 == eng6 );
+}
+
+BOOST_AUTO_TEST_CASE( philox4x32_kat )
+{
+    check_counter_based_kat<boost::random::philox4x32_10>("0 0 0 0 0 0 0", "6627e8d5 e169c58d bc57ac4c 9b00dbd8");
+    check_counter_based_kat<boost::random::philox4x32_10>("4294967295 4294967295 4294967295 4294967295 4294967295 4294967295 0", "408f276d 41c83b0e a20bc7c6 6d5451fd");
+    check_counter_based_kat<boost::random::philox4x32_10>("2752067618 698298832 608135816 2242054355 320440878 57701188 0", "d16cfe09 94fdcceb 5001e420 24126ea1");
+}
+
+BOOST_AUTO_TEST_CASE( philox4x64_kat )
+{
+    check_counter_based_kat<boost::random::philox4x64_10_64>("0 0 0 0 0 0 0", "16554d9eca36314c db20fe9d672d0fdc d7e772cee186176b 7e68b68aec7ba23b");
+    check_counter_based_kat<boost::random::philox4x64_10_64>("18446744073709551615 18446744073709551615 18446744073709551615 18446744073709551615 18446744073709551615 18446744073709551615 0", "87b092c3013fe90b 438c3c67be8d0224 9cc7d7c69cd777b6 a09caebf594f0ba0");
+    check_counter_based_kat<boost::random::philox4x64_10_64>("4983270260364809079 13714699805381954668 2611923443488327891 1376283091369227076 11820040416388919760 589684135938649225 0", "a528f45403e61d95 38c72dbd566e9788 a5a1610e72fd18b5 57bd43b5e52b7fe6");
+}
+
+BOOST_AUTO_TEST_CASE( philox4x64_interface )
+{
+    // the 64 bit words of a block as 32 and 16 bit values
+    boost::random::philox4x64_10_64 eng64(42);
+    boost::random::counter_based_engine<boost::uint32_t, 32, boost::random::philox4x64<10> > eng32(42);
+    boost::random::counter_based_engine<boost::uint16_t, 16, boost::random::philox4x64<10> > eng16(42);
+    for (int i=0; i<8; ++i) {
+        boost::uint64_t w = eng64();
+        BOOST_CHECK_EQUAL( eng32(), w & 0xffffffff );
+        BOOST_CHECK_EQUAL( eng32(), w >> 32 );
+        for (int j=0; j<4; ++j)
+            BOOST_CHECK_EQUAL( eng16(), (w >> (16*j)) & 0xffff );
+    }
+
+    // discard is O(1) and equals drawing
+    boost::random::philox4x64_10_64 eng1(42);
+    boost::random::philox4x64_10_64 eng2(42);
+    eng1.discard(4*1000000 + 3);
+    std::istringstream is("42 0 1000000 0 0 0 3");
+    is >> eng2;
+    BOOST_CHECK( eng1 == eng2 );
+    BOOST_CHECK_EQUAL( eng1(), eng2() );
+
+    boost::random::philox4x32_10 eng3(7);
+    boost::random::philox4x32_10 eng4(7);
+    for (int i=0; i<13; ++i) eng3();
+    eng4.discard(13);
+    BOOST_CHECK( eng3 == eng4 );
+    BOOST_CHECK_EQUAL( eng3(), eng4() );
+
+    // stream round trip
+    std::stringstream ss;
+    ss << eng3;
+    boost::random::philox4x32_10 eng5;
+    ss >> eng5;
+    BOOST_CHECK( eng3 == eng5 );
+    BOOST_CHECK_EQUAL( eng3(), eng5() );
+}
+
+template<std::size_t Rounds>
+void check_rounds_multiple_of_40(boost::uint64_t first)
+{
+    // exactly Rounds rounds, earlier versions did one more when Rounds was a multiple of 40
+    typedef boost::random::threefry4x64<Rounds> threefry;
+    boost::random::threefry4x64_engine<boost::uint64_t, 64, Rounds> eng;
+    BOOST_CHECK_EQUAL( eng(), first );
+
+    const typename threefry::key_type key = {{ 0x452821e638d01377, 0xbe5466cf34e90c6c, 0xbe5466cf34e90c6c, 0xc0ac29b7c97c50dd }};
+    const typename threefry::ctr_type ctr = {{ 0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89 }};
+    std::ostringstream os;
+    os << key[0] << ' ' << key[1] << ' ' << key[2] << ' ' << key[3] << ' '
+       << ctr[0] << ' ' << ctr[1] << ' ' << ctr[2] << ' ' << ctr[3] << ' ' << 0;
+    std::istringstream is( os.str() );
+    is >> eng;
+    const typename threefry::ctr_type out = threefry::encrypt(key, ctr);
+    for (std::size_t i=0; i<4; ++i)
+        BOOST_CHECK_EQUAL( eng(), out[i] );
+}
+
+BOOST_AUTO_TEST_CASE( threefry4x64_rounds_multiple_of_40 )
+{
+    check_rounds_multiple_of_40<40>(0x79ab69a98327020f);
+    check_rounds_multiple_of_40<80>(0xa92d861d1b994afc);
+}
+
+template<class Engine>
+void check_counter_based_engine()
+{
+    for (std::size_t nblocks=0; nblocks<=35; ++nblocks) {
+        check_counter_blocks<Engine>(nblocks % 5, nblocks);
+        check_counter_blocks<Engine>(nblocks % 5, nblocks % 3 + 1, true);
+    }
+    check_fill<Engine>();
+    check_seek<Engine>(77);
+}
+
+BOOST_AUTO_TEST_CASE( counter_based_engine_bulk )
+{
+    // the bulk and positioning interface of threefry4x64_engine
+    check_counter_based_engine< boost::random::threefry4x32_20 >();
+    check_counter_based_engine< boost::random::threefry2x64_13_64 >();
+    check_counter_based_engine< boost::random::threefry2x32_20 >();
+    check_counter_based_engine< boost::random::philox4x32_10 >();
+    check_counter_based_engine< boost::random::philox4x64_10_64 >();
+    check_fill< boost::random::counter_based_engine<boost::uint8_t, 8, boost::random::threefry4x32<20> > >();
+    check_fill< boost::random::counter_based_engine<boost::uint64_t, 64, boost::random::threefry2x32<20> > >();
+    check_seek< boost::random::counter_based_engine<boost::uint64_t, 64, boost::random::threefry2x32<20> > >(77);
+    check_seek< boost::random::counter_based_engine<boost::uint16_t, 16, boost::random::threefry2x64<20> > >(77);
+}
+
+// the first block of stream s has the counter ctr
+template<class Engine>
+void check_counter_based_stream(boost::uint64_t s, const typename Engine::ctr_type& ctr)
+{
+    typedef typename Engine::cipher_type cipher;
+    typename Engine::key_type key = typename Engine::key_type();
+    key[0] = 5;
+    const Engine eng(5);
+    BOOST_CHECK_EQUAL( eng.stream(), 0u );
+
+    Engine sub = eng.substream(s);
+    BOOST_CHECK_EQUAL( sub.stream(), s );
+    const typename Engine::ctr_type block = cipher::encrypt(key, ctr);
+    for (std::size_t i=0; i<Engine::ctr_words; ++i)
+        BOOST_CHECK_EQUAL( sub(), block[i] );
+    BOOST_CHECK_EQUAL( sub.stream(), s );
+
+    // one value back is the end of stream s-1
+    typename Engine::position_type back = typename Engine::position_type();
+    for (std::size_t i=0; i+1<back.size(); ++i)
+        back[i] = 0xFFFFFFFFFFFFFFFF;
+    back[back.size()-1] = Engine::samples_per_block - 1;
+    Engine prev = eng.substream(s);
+    prev.discard(back);
+    BOOST_CHECK_EQUAL( prev.stream(), s - 1 );
+    prev();
+    BOOST_CHECK( prev == eng.substream(s) );
+}
+
+BOOST_AUTO_TEST_CASE( counter_based_engine_streams )
+{
+    using namespace boost::random;
+    BOOST_CHECK_EQUAL( threefry4x32_20::stream_bits, 64u );
+    BOOST_CHECK_EQUAL( threefry2x32_20::stream_bits, 32u );
+    const threefry4x32<20>::ctr_type c4x32 = {{ 0, 0, 3, 1 }};
+    check_counter_based_stream<threefry4x32_20>(0x100000003ULL, c4x32);
+    const threefry2x64<20>::ctr_type c2x64 = {{ 0, 0x100000003ULL }};
+    check_counter_based_stream<threefry2x64_20_64>(0x100000003ULL, c2x64);
+    const threefry2x32<20>::ctr_type c2x32 = {{ 0, 3 }};
+    check_counter_based_stream<threefry2x32_20>(3, c2x32);
+    const philox4x64<10>::ctr_type c4x64 = {{ 0, 0, 0, 7 }};
+    check_counter_based_stream<philox4x64_10_64>(7, c4x64);
+
+    // the pool hands out their streams
+    engine_pool<threefry4x32_20> pool(threefry4x32_20(5), 3);
+    BOOST_CHECK( pool.acquire() == threefry4x32_20(5).substream(3) );
+    engine_pool<threefry2x32_20> small_pool(threefry2x32_20(5), 0xFFFFFFFF);
+    BOOST_CHECK( small_pool.acquire() == threefry2x32_20(5).substream(0xFFFFFFFF) );
+    BOOST_CHECK_THROW( small_pool.acquire(), std::out_of_range );
+}